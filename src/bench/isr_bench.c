@@ -0,0 +1,299 @@
+//*****************************************************************************************************
+//
+// file:      bench/isr_bench.c
+// purpose:   Cycle counts of the interrupt service routines, measured on the real firmware
+//            (OpenDecoder2.elf) running under simavr
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-16 V0.1 Initial version
+//            2026-10-16 V0.2 Refuses MCUs other than the ATmega16
+//
+// usage:     isr_bench <firmware.elf> [mcu] [frequency] [seconds]
+//            Normally started via "make bench". Only the ATmega16 is supported (see isr[]).
+//
+//*****************************************************************************************************
+//
+// The firmware runs with the EEPROM contents of the .elf file (the same data as "make flash").
+// Two stimuli drive the input pins:
+// - DCC (INT1, PD3):   an endless sequence of accessory commands for our own address, accessory
+//                      commands for other addresses, loco speed commands and idle packets
+// - RS-bus (INT0, PD2): polling cycles of 130 pulses of 200us, each followed by 7ms silence
+// simavr signals for every interrupt vector when it becomes pending and when it starts and ends
+// (RETI). From these signals we determine per ISR:
+// - the number of cycles spent in the ISR itself (from vectoring till RETI). If another interrupt
+//   interrupts the ISR (TIMER1_OVF calls sei()), the cycles of that interrupt are not counted.
+// - the latency: the number of cycles between setting the interrupt flag and vectoring.
+// Each ISR has a budget: the time before the next event of the same source must be handled.
+// If latency + execution time exceeds the budget, the program exits with 1, so "make bench"
+// fails.
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_core.h"
+#include "sim_interrupts.h"
+#include "sim_cycle_timers.h"
+#include "sim_time.h"
+#include "avr_ioport.h"
+
+
+//*****************************************************************************************************
+// Interrupt vectors that are measured (vector numbers of the ATmega16)
+// Other MCUs number their vectors differently; with them we would measure the wrong ISRs, and the
+// results would look valid. Therefore the benchmark refuses to run for any other MCU.
+//*****************************************************************************************************
+#define BENCH_MCU "atmega16"
+
+typedef struct
+  {
+    const char *name;
+    uint8_t vector;
+    uint32_t budget_us;                       // time till the next event of this source
+    // results
+    unsigned long calls;
+    avr_cycle_count_t min, max, total;        // cycles in the ISR itself
+    avr_cycle_count_t max_latency;            // cycles between interrupt flag and vectoring
+    avr_cycle_count_t pending_since;
+  } t_isr;
+
+static t_isr isr[] = {
+  {"INT0 (RS-bus)",         1,   200},        // RS-bus poll pulse every 200us
+  {"INT1 (DCC)",            2,    58},        // shortest DCC half bit
+  {"TIMER2_COMP (RS-bus)",  3,  1000},        // 1 ms tick
+  {"TIMER1_OVF (20ms tick)", 8, 20000},
+  {"TIMER0_OVF (DCC)",      9,    39},        // samples 77us after the edge; next edge at 116us
+};
+#define NR_ISRS (sizeof(isr) / sizeof(isr[0]))
+
+// Nesting: stack of ISRs that are running
+typedef struct
+  {
+    t_isr *isr;
+    avr_cycle_count_t start;
+    avr_cycle_count_t nested;                 // cycles spent in interrupts of this ISR
+  } t_running;
+
+static t_running running[16];
+static int running_depth;
+static avr_t *avr;
+
+static void isr_pending(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  t_isr *p = param;
+  if (value && !p->pending_since) p->pending_since = avr->cycle;
+}
+
+static void isr_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+  t_isr *p = param;
+  if (value)
+  {
+    // Vectoring: the ISR starts
+    if (p->pending_since)
+    {
+      avr_cycle_count_t latency = avr->cycle - p->pending_since;
+      if (latency > p->max_latency) p->max_latency = latency;
+      p->pending_since = 0;
+    }
+    if (running_depth < 16)
+    {
+      running[running_depth].isr = p;
+      running[running_depth].start = avr->cycle;
+      running[running_depth].nested = 0;
+    }
+    running_depth++;
+  }
+  else if (running_depth > 0)
+  {
+    // RETI
+    running_depth--;
+    if (running_depth < 16)
+    {
+      avr_cycle_count_t duration = avr->cycle - running[running_depth].start;
+      avr_cycle_count_t self = duration - running[running_depth].nested;
+      if (p->calls == 0 || self < p->min) p->min = self;
+      if (self > p->max) p->max = self;
+      p->total += self;
+      p->calls++;
+      if (running_depth > 0) running[running_depth - 1].nested += duration;
+    }
+  }
+}
+
+
+//*****************************************************************************************************
+// DCC stimulus
+//*****************************************************************************************************
+// The packets that are sent in turn (the last byte is the XOR byte)
+static const uint8_t dcc_packets[][4] = {
+  {3, 0x81, 0xF8, 0x79},                      // accessory, address 1 (our default), gate 0 on
+  {3, 0x81, 0xF9, 0x78},                      // accessory, address 1, gate 1 on
+  {3, 0x85, 0xF8, 0x7D},                      // accessory, other decoder
+  {3, 0x03, 0x3F, 0x3C},                      // loco 3, speed step
+  {3, 0xFF, 0x00, 0xFF},                      // idle
+};
+#define NR_PACKETS (sizeof(dcc_packets) / sizeof(dcc_packets[0]))
+
+static struct
+  {
+    avr_irq_t *pin;
+    uint8_t bits[64];                         // bits of the current packet
+    uint8_t nr_bits;
+    uint8_t bit;                              // bit being sent
+    uint8_t level;                            // 1 = first half, 0 = second half
+    uint8_t packet;
+  } dcc;
+
+static void dcc_next_packet(void)
+{
+  const uint8_t *p = dcc_packets[dcc.packet];
+  uint8_t i, j;
+  dcc.nr_bits = 0;
+  for (i = 0; i < 14; i++) dcc.bits[dcc.nr_bits++] = 1;     // preamble
+  for (i = 1; i <= p[0]; i++)
+  {
+    dcc.bits[dcc.nr_bits++] = 0;                            // start bit
+    for (j = 0; j < 8; j++) dcc.bits[dcc.nr_bits++] = (p[i] >> (7 - j)) & 1;
+  }
+  dcc.bits[dcc.nr_bits++] = 1;                              // end bit
+  dcc.bit = 0;
+  dcc.packet = (dcc.packet + 1) % NR_PACKETS;
+}
+
+static avr_cycle_count_t dcc_edge(struct avr_t *avr, avr_cycle_count_t when, void *param)
+{
+  uint32_t half_us;
+  if (dcc.level == 0)
+  {
+    // Start of a new bit
+    if (dcc.bit >= dcc.nr_bits) dcc_next_packet();
+    dcc.level = 1;
+  }
+  else
+  {
+    dcc.level = 0;
+  }
+  half_us = dcc.bits[dcc.bit] ? 58 : 100;
+  if (dcc.level == 0) dcc.bit++;
+  avr_raise_irq(dcc.pin, dcc.level);
+  return when + avr_usec_to_cycles(avr, half_us);
+}
+
+
+//*****************************************************************************************************
+// RS-bus stimulus
+//*****************************************************************************************************
+static struct
+  {
+    avr_irq_t *pin;
+    uint8_t pulse;                            // 0..129
+    uint8_t level;
+  } rs;
+
+static avr_cycle_count_t rs_edge(struct avr_t *avr, avr_cycle_count_t when, void *param)
+{
+  if (rs.level)
+  {
+    // Falling edge: INT0 in the decoder
+    rs.level = 0;
+    avr_raise_irq(rs.pin, 0);
+    return when + avr_usec_to_cycles(avr, 100);
+  }
+  rs.level = 1;
+  avr_raise_irq(rs.pin, 1);
+  if (++rs.pulse < 130) return when + avr_usec_to_cycles(avr, 100);
+  rs.pulse = 0;
+  return when + avr_usec_to_cycles(avr, 7000);              // idle period
+}
+
+
+//*****************************************************************************************************
+// Main
+//*****************************************************************************************************
+int main(int argc, char *argv[])
+{
+  elf_firmware_t f;
+  const char *mcu = (argc > 2) ? argv[2] : BENCH_MCU;
+  uint32_t frequency = (argc > 3) ? strtoul(argv[3], NULL, 10) : 11059200;
+  double seconds = (argc > 4) ? atof(argv[4]) : 5.0;
+  avr_cycle_count_t end;
+  unsigned int i;
+  int state, result = 0;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s <firmware.elf> [mcu] [frequency] [seconds]\n", argv[0]);
+    return 2;
+  }
+  memset(&f, 0, sizeof(f));
+  if (elf_read_firmware(argv[1], &f) != 0)
+  {
+    fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+    return 2;
+  }
+  if ((strcmp(mcu, BENCH_MCU) != 0) || ((f.mmcu[0] != 0) && (strcmp(f.mmcu, BENCH_MCU) != 0)))
+  {
+    fprintf(stderr, "%s: the vector numbers are those of the %s; %s is not supported\n", argv[0],
+            BENCH_MCU, (strcmp(mcu, BENCH_MCU) != 0) ? mcu : f.mmcu);
+    return 2;
+  }
+  avr = avr_make_mcu_by_name(mcu);
+  if (!avr)
+  {
+    fprintf(stderr, "%s: unknown mcu %s\n", argv[0], mcu);
+    return 2;
+  }
+  avr_init(avr);
+  f.frequency = frequency;
+  avr_load_firmware(avr, &f);                 // also loads the EEPROM section
+  avr->frequency = frequency;
+  avr->log = LOG_WARNING;
+
+  for (i = 0; i < NR_ISRS; i++)
+  {
+    avr_irq_t *irq = avr_get_interrupt_irq(avr, isr[i].vector);
+    avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, isr_pending, &isr[i]);
+    avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, isr_running, &isr[i]);
+  }
+
+  // Both input lines start high; the first edges follow after 1 ms
+  dcc.pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 3);
+  rs.pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 2);
+  avr_raise_irq(dcc.pin, 1);
+  avr_raise_irq(rs.pin, 1);
+  rs.level = 1;
+  avr_cycle_timer_register_usec(avr, 1000, dcc_edge, NULL);
+  avr_cycle_timer_register_usec(avr, 1000, rs_edge, NULL);
+
+  end = avr_usec_to_cycles(avr, (uint32_t)(seconds * 1000000));
+  do state = avr_run(avr);
+    while ((avr->cycle < end) && (state != cpu_Done) && (state != cpu_Crashed));
+  if (state == cpu_Crashed) {fprintf(stderr, "firmware crashed\n"); return 2;}
+
+  printf("%.1f s simulated at %lu Hz (%s)\n", seconds, (unsigned long)frequency, mcu);
+  printf("%-24s %8s %7s %7s %7s %9s %8s %8s\n",
+         "ISR", "calls", "min", "avg", "max", "max lat.", "worst us", "budget");
+  for (i = 0; i < NR_ISRS; i++)
+  {
+    t_isr *p = &isr[i];
+    double worst_us = (p->max + p->max_latency) * 1000000.0 / frequency;
+    if (p->calls == 0)
+    {
+      printf("%-24s %8s\n", p->name, "-");
+      continue;
+    }
+    printf("%-24s %8lu %7lu %7lu %7lu %9lu %8.1f %6luus%s\n", p->name, p->calls,
+           (unsigned long)p->min, (unsigned long)(p->total / p->calls), (unsigned long)p->max,
+           (unsigned long)p->max_latency, worst_us, (unsigned long)p->budget_us,
+           (worst_us > p->budget_us) ? "  OVER BUDGET" : "");
+    if (worst_us > p->budget_us) result = 1;
+  }
+  return result;
+}
@@ -16,6 +16,9 @@
 // webpage:   http://www.opendcc.de
 // history:   2007-02-14 V0.1  kw start
 //            2011-12-31 V0.14 ap changed #define OPENDECODER22 0x2F
+//            2026-10-16 V0.15    _restart() calls host_restart() in the host build
+//            2026-10-16 V0.16    timer1fired replaced by the event mask (events)
+//                                EV_TICK replaced by EV_TIMER (software timers, see timer1.h)
 //
 //------------------------------------------------------------------------
 //
@@ -99,9 +102,15 @@ extern const t_cv_record CV_PRESET PROGMEM;
 
 extern volatile signed char timerval;     // gets incremented in the timetick
 
-// The following flag is included to move non-critical code away from the timer1 ISR
-// Main is now checking this flag
-extern volatile unsigned char timer1fired; // Indicates timer 1 has fired
+// Events: the ISRs set a bit in this mask for work that should be done by main. Main takes the 
+// bits (with interrupts disabled), handles them, and sleeps (SLEEP_MODE_IDLE) if no bit is set.
+// Note: an ISR that enables interrupts (sei) must set its bit before doing so.
+extern volatile unsigned char events;
+#define EV_DCC          0       // dcc_receiver.c: one or more DCC messages are available
+#define EV_TIMER        1       // timer1.c: one or more software timers have expired
+#define EV_BUTTON       2       // timer1.c: the programming button is pressed (checked each tick)
+#define EV_FEEDBACK     3       // rs_bus_hardware.c: a feedback sample (CV35 > 0) needs sending
+#define EV_PULSE        4       // switch.c: a coil pulse timed by the Timer2 ISR is over
 
 
 
@@ -124,8 +133,8 @@ extern volatile unsigned char timer1fired; // Indicates timer 1 has fired
 extern volatile unsigned char Communicate;
 
 
-#define C_Received        0    // a new DCC was received - issued by ISR(Timer1)
-                               //                          cleared by main
+#define C_Received        0    // no longer used: received DCC messages are
+                               // queued in dcc_ring (see dcc_receiver.h)
 #define C_DoSave          1    // a new PORT state should be saved
                                //                        - issued by action
                                //                          cleared by main
@@ -195,6 +204,10 @@ _mydelay_us(double __us)
     _delay_loop_2(__ticks);
 }   
 
+#if defined(HOST_BUILD)
+  void host_restart(void);
+#endif
+
 static inline void _restart(void) __attribute__((always_inline));
 void
 _restart(void)
@@ -206,10 +219,14 @@ _restart(void)
     // void (*funcptr)( void ) = 0x0000;    // Set up function pointer
     // funcptr();                        // Jump to Reset vector 0x0000
     
+#if defined(HOST_BUILD)
+    host_restart();                      // host/hal_host.c: only counts the restart
+#else
     __asm__ __volatile 
     (
        "ldi r30,0"  "\n\t"
        "ldi r31,0"  "\n\t"
        "icall" "\n\t"
      );
+#endif
 }
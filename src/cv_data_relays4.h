@@ -28,6 +28,13 @@
 //                               needs to be included multiple times!
 //                               It would be more logical to change the file extension to .ini, but
 //                               the Arduino IDE can only deal with .c, .cpp and .h files.
+//            2026-10-16 v0.9    FBDebounce (CV35) added
+//                               ThrowLimit and AlarmRsAddr (CV36-CV37) added
+//                               Throw times (CV38-CV49) added; the values are kept in RAM
+//                               MaxCoils (CV50) and PulseUnit (CV51) added
+//                               HoldDuty (CV52) and PullIn (CV53) added
+//                               Four routes (CV54-CV77) added
+//                               DecType is DECODER_TYPE, so this file is also used for relays16
 //
 //-----------------------------------------------------------------------------
 // NOTE: Don't include an #pragma once clause!!
@@ -67,7 +74,7 @@
    0,           // cv536        24  R      not used
    0,           // Restart      25  R/W    To restart (as opposed to reset) the decoder: use after PoM write
    0,           // DccQuality   26  R/W    DCC Signal Quality
-   0b00100000,  // DecType      27  R/W    Decoder Type
+   DECODER_TYPE, // DecType     27  R/W    Decoder Type (TYPE_RELAYS4 = 0b00100000 / TYPE_RELAYS16)
 						// 0x00010000 - Switch decoder
 						// 0x00010001 - Switch decoder with Emergency board
 						// 0x00010100 - Servo decoder
@@ -91,3 +98,57 @@
                                            // received (since this generates feedback, is needed by Railware)
                                            // If zero, will not activate coil / relays if it is already 
                                            // in the requested position
+   0,           // FBDebounce	35  R/W    Feedback sampling: 0 = each 20ms, 8 equal samples needed (slow)
+                                           // 1..8 = each 1ms, this number of equal samples needed
+   0,           // ThrowLimit	36  R/W    Throw time (in 20ms steps) above which an RS-bus alarm is raised
+                                           // 0 = no alarms
+   0,           // AlarmRsAddr	37  R/W    RS-bus address for throw time alarms (1..128 / not set: 0)
+   0,           // ThrowLast1	38  R      Last throw time of switch 1 (RAM; in 20ms steps)
+   0,           // ThrowLast2	39  R      Last throw time of switch 2 (RAM)
+   0,           // ThrowLast3	40  R      Last throw time of switch 3 (RAM)
+   0,           // ThrowLast4	41  R      Last throw time of switch 4 (RAM)
+   0,           // ThrowMin1	42  R      Minimum throw time of switch 1 (RAM)
+   0,           // ThrowMin2	43  R      Minimum throw time of switch 2 (RAM)
+   0,           // ThrowMin3	44  R      Minimum throw time of switch 3 (RAM)
+   0,           // ThrowMin4	45  R      Minimum throw time of switch 4 (RAM)
+   0,           // ThrowMax1	46  R      Maximum throw time of switch 1 (RAM)
+   0,           // ThrowMax2	47  R      Maximum throw time of switch 2 (RAM)
+   0,           // ThrowMax3	48  R      Maximum throw time of switch 3 (RAM)
+   0,           // ThrowMax4	49  R      Maximum throw time of switch 4 (RAM)
+   0,           // MaxCoils	50  R/W    Maximum number of coils / relays that are active at the same time
+                                           // Other activations wait (0 = no limit)
+   20,          // PulseUnit	51  R/W    Unit of the hold times T_on_F1..F4 (CV3..CV6)
+                                           // 0 = 20ms ticks (pulse may be up to 20ms shorter)
+                                           // 1..255 = this number of ms (pulse accurate to 1ms)
+   0,           // HoldDuty	52  R/W    PWM hold: after the pull-in pulse, the coil is on for HoldDuty ms
+                                           // out of each 8 ms (0 = no PWM, coil fully on). Needs CV51 > 0
+                                           // With T_on = 0 (hold for ever), PWM reduces the holding current
+   5,           // PullIn	53  R/W    Pull-in time with the coil fully on, before PWM hold (in CV51 units)
+   0,           // Route1AddrL	54  R/W    Switch number (1..2048, as on the handheld) that triggers route 1; low byte
+                                           // 0 = route not used. A command for either gate runs the route
+   0,           // Route1AddrH	55  R/W    Switch number that triggers route 1; high byte (bits 10..8)
+   0,           // Route1Step1	56  R/W    First step of route 1. Bits DDDGPPPP:
+                                           // DDD = delay before this step (in 200ms steps, 0..1.4s)
+                                           // G = gate (0 = green / 1 = red), PPPP = device (1..8; 0 = none)
+                                           // 0 = no step (end of the route)
+   0,           // Route1Step2	57  R/W    Step 2 of route 1
+   0,           // Route1Step3	58  R/W    Step 3 of route 1
+   0,           // Route1Step4	59  R/W    Step 4 of route 1
+   0,           // Route2AddrL	60  R/W    Switch number that triggers route 2; low byte (0 = not used)
+   0,           // Route2AddrH	61  R/W    Switch number that triggers route 2; high byte
+   0,           // Route2Step1	62  R/W    Step 1 of route 2
+   0,           // Route2Step2	63  R/W    Step 2 of route 2
+   0,           // Route2Step3	64  R/W    Step 3 of route 2
+   0,           // Route2Step4	65  R/W    Step 4 of route 2
+   0,           // Route3AddrL	66  R/W    Switch number that triggers route 3; low byte (0 = not used)
+   0,           // Route3AddrH	67  R/W    Switch number that triggers route 3; high byte
+   0,           // Route3Step1	68  R/W    Step 1 of route 3
+   0,           // Route3Step2	69  R/W    Step 2 of route 3
+   0,           // Route3Step3	70  R/W    Step 3 of route 3
+   0,           // Route3Step4	71  R/W    Step 4 of route 3
+   0,           // Route4AddrL	72  R/W    Switch number that triggers route 4; low byte (0 = not used)
+   0,           // Route4AddrH	73  R/W    Switch number that triggers route 4; high byte
+   0,           // Route4Step1	74  R/W    Step 1 of route 4
+   0,           // Route4Step2	75  R/W    Step 2 of route 4
+   0,           // Route4Step3	76  R/W    Step 3 of route 4
+   0,           // Route4Step4	77  R/W    Step 4 of route 4
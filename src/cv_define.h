@@ -1,82 +1,136 @@
-//------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder2.2
-//
-// Copyright (c) 2007 Kufer
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-// 
-//------------------------------------------------------------------------
-//
-// file:      cv_data_servo.h
-// author:    Wolfgang Kufer
-// contact:   kufer@gmx.de
-// webpage:   http://www.opendcc.de
-// history:   2007-08-03 V0.1 kw start
-//            2011-01-15 V0.2 ap New CV have been added: CmdStation. 
-//                               Note that "reserved CVs" have been (mis)used for this purpose
-//                               CmdStation is included to correct "errors" made by LENZ LZV100
-//                               master stations. Although this correction will not be needed if 
-//                               the decoder is used in the traditional way (controlling four 
-//                               switches via four subsequent addresses, no RS-bus feedback), it 
-//                               will improve operation if it is used together with 
-//                               LENZ LZV100 master stations.
-//            2012-01-03 v0.3 ap New Cvs for GBM added. 
-//            2012-12-27 v0.4 ap Cvs have been reorded and cleaned up, to better support PoM.
-//            2013-03-12 v0.5 ap The ability is added to program the CVs on the main (PoM).
-//            2014-01-06 v0.6 ap SendFB and AlwaysAct added
-//
-//
-//------------------------------------------------------------------------
-//
-// purpose:   flexible general purpose decoder for dcc
-//            This is the cv-structure definition for the project
-//            cv_data_xxxxx.h will contain the actual data.
-//
-//========================================================================
-#pragma once
-
-typedef struct
-  {
-    //            Name          CV   alt  Access comment
-    unsigned char myAddrL;      //513   1  R/W    Accessory Address low (6 bits). Note: not the RS-Bus address
-    unsigned char cv514;        //514   2  R      not used
-    unsigned char T_on_F1;      //515   3  R      Hold time for relays 1 (in 20ms steps)
-    unsigned char T_on_F2;      //516   4  R      Same dor relays 2
-    unsigned char T_on_F3;      //517   5  R      Same dor relays 3
-    unsigned char T_on_F4;      //518   6  R      Same dor relays 4
-    unsigned char version;      //519   7  R      Version. Should be > 7
-    unsigned char VID;          //520   8  R/W    Vendor ID (0x0D = DIY Decoder
-                                                    // write value 0x0D = 13 to reset CVs to default values
-    unsigned char myAddrH;      //521   9  R/W    Accessory Address high (3 bits)
-    unsigned char MyRsAddr;     //522  10  R/W    RS-bus address of this feedback decoder
-    unsigned char cv523;        //523  11  R      not used
-    unsigned char cv524;        //524  12  R      not used
-    unsigned char cv525;        //525  13  R      not used
-    unsigned char cv526;        //526  14  R      not used
-    unsigned char cv527;        //527  15  R      not used
-    unsigned char cv528;        //528  16  R      not used
-    unsigned char cv529;        //529  17  R      not used
-    unsigned char cv530;        //530  18  R      not used
-    unsigned char CmdStation;   //531  19  R/W    Command Station. 0 = standard / 1 = Lenz
-    unsigned char RSRetry;      //532  20  R/W    Number of RS-Bus retransmissions
-    unsigned char SkipUnEven;   //533  21  R/W    Only Decoder Addresses 2, 4, 6 .... 1024 will be used
-    unsigned char cv534;        //534  22  R      not used
-    unsigned char Search;       //535  23  R/W*   If set to 1: decoder LED blinks. Value will be 0 after restart
-    unsigned char cv536;        //536  24  R      not used
-    unsigned char Restart;      //537  25  R/W*   To restart (as opposed to reset) the decoder: use after PoM write
-    unsigned char DccQuality;   //538  26  R      DCC Signal Quality
-    unsigned char DecType;      //539  27  R      Decoder Type (see global.h for possible values)
-    unsigned char BiDi;         //540  28  R      Bi-Directional Communication Config. Since BiDi is not used, keep at 0
-    unsigned char Config;       //541  29  R      Accessory Decoder configuration (similar to CV#29)
-    unsigned char VID_2;        //542  30  R      Second Vendor ID, to detect AP decoders
-    unsigned char cv543;        //543  31  R      not used
-    unsigned char cv544;        //544  32  R      not used
-
-    unsigned char SendFB;	//545  33  R/W    Decoder will send switch feedback messages via RS-Bus 
-    unsigned char AlwaysAct;	//546  34  R/W    Decoder will activate coil / relays for each DCC command received
-
-    
- } t_cv_record;
+//------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder2.2
+//
+// Copyright (c) 2007 Kufer
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+// 
+//------------------------------------------------------------------------
+//
+// file:      cv_data_servo.h
+// author:    Wolfgang Kufer
+// contact:   kufer@gmx.de
+// webpage:   http://www.opendcc.de
+// history:   2007-08-03 V0.1 kw start
+//            2011-01-15 V0.2 ap New CV have been added: CmdStation. 
+//                               Note that "reserved CVs" have been (mis)used for this purpose
+//                               CmdStation is included to correct "errors" made by LENZ LZV100
+//                               master stations. Although this correction will not be needed if 
+//                               the decoder is used in the traditional way (controlling four 
+//                               switches via four subsequent addresses, no RS-bus feedback), it 
+//                               will improve operation if it is used together with 
+//                               LENZ LZV100 master stations.
+//            2012-01-03 v0.3 ap New Cvs for GBM added. 
+//            2012-12-27 v0.4 ap Cvs have been reorded and cleaned up, to better support PoM.
+//            2013-03-12 v0.5 ap The ability is added to program the CVs on the main (PoM).
+//            2014-01-06 v0.6 ap SendFB and AlwaysAct added
+//            2026-10-16 v0.7    FBDebounce added
+//                               ThrowLimit and AlarmRsAddr added, throw time CVs 38-49 (kept in RAM)
+//                               MaxCoils and PulseUnit added
+//                               HoldDuty and PullIn added
+//                               Route tables added (CV54-CV77)
+//
+//
+//------------------------------------------------------------------------
+//
+// purpose:   flexible general purpose decoder for dcc
+//            This is the cv-structure definition for the project
+//            cv_data_xxxxx.h will contain the actual data.
+//
+//========================================================================
+#pragma once
+
+typedef struct
+  {
+    //            Name          CV   alt  Access comment
+    unsigned char myAddrL;      //513   1  R/W    Accessory Address low (6 bits). Note: not the RS-Bus address
+    unsigned char cv514;        //514   2  R      not used
+    unsigned char T_on_F1;      //515   3  R      Hold time for relays 1 (in 20ms steps)
+    unsigned char T_on_F2;      //516   4  R      Same dor relays 2
+    unsigned char T_on_F3;      //517   5  R      Same dor relays 3
+    unsigned char T_on_F4;      //518   6  R      Same dor relays 4
+    unsigned char version;      //519   7  R      Version. Should be > 7
+    unsigned char VID;          //520   8  R/W    Vendor ID (0x0D = DIY Decoder
+                                                    // write value 0x0D = 13 to reset CVs to default values
+    unsigned char myAddrH;      //521   9  R/W    Accessory Address high (3 bits)
+    unsigned char MyRsAddr;     //522  10  R/W    RS-bus address of this feedback decoder
+    unsigned char cv523;        //523  11  R      not used
+    unsigned char cv524;        //524  12  R      not used
+    unsigned char cv525;        //525  13  R      not used
+    unsigned char cv526;        //526  14  R      not used
+    unsigned char cv527;        //527  15  R      not used
+    unsigned char cv528;        //528  16  R      not used
+    unsigned char cv529;        //529  17  R      not used
+    unsigned char cv530;        //530  18  R      not used
+    unsigned char CmdStation;   //531  19  R/W    Command Station. 0 = standard / 1 = Lenz
+    unsigned char RSRetry;      //532  20  R/W    Number of RS-Bus retransmissions
+    unsigned char SkipUnEven;   //533  21  R/W    Only Decoder Addresses 2, 4, 6 .... 1024 will be used
+    unsigned char cv534;        //534  22  R      not used
+    unsigned char Search;       //535  23  R/W*   If set to 1: decoder LED blinks. Value will be 0 after restart
+    unsigned char cv536;        //536  24  R      not used
+    unsigned char Restart;      //537  25  R/W*   To restart (as opposed to reset) the decoder: use after PoM write
+    unsigned char DccQuality;   //538  26  R      DCC Signal Quality
+    unsigned char DecType;      //539  27  R      Decoder Type (see global.h for possible values)
+    unsigned char BiDi;         //540  28  R      Bi-Directional Communication Config. Since BiDi is not used, keep at 0
+    unsigned char Config;       //541  29  R      Accessory Decoder configuration (similar to CV#29)
+    unsigned char VID_2;        //542  30  R      Second Vendor ID, to detect AP decoders
+    unsigned char cv543;        //543  31  R      not used
+    unsigned char cv544;        //544  32  R      not used
+
+    unsigned char SendFB;	//545  33  R/W    Decoder will send switch feedback messages via RS-Bus 
+    unsigned char AlwaysAct;	//546  34  R/W    Decoder will activate coil / relays for each DCC command received
+    unsigned char FBDebounce;	//547  35  R/W    Feedback: 0 = sample each 20ms (8 samples) / 1..8 = sample each 1ms, number of samples
+    unsigned char ThrowLimit;	//548  36  R/W    Throw time (20ms steps) above which an alarm is raised. 0 = no alarm
+    unsigned char AlarmRsAddr;	//549  37  R/W    RS-bus address for throw time alarms (1..128). 0 = no alarms
+    unsigned char ThrowLast1;	//550  38  R      Last throw time of switch 1 (20ms steps)
+    unsigned char ThrowLast2;	//551  39  R      Last throw time of switch 2
+    unsigned char ThrowLast3;	//552  40  R      Last throw time of switch 3
+    unsigned char ThrowLast4;	//553  41  R      Last throw time of switch 4
+    unsigned char ThrowMin1;	//554  42  R      Minimum throw time of switch 1
+    unsigned char ThrowMin2;	//555  43  R      Minimum throw time of switch 2
+    unsigned char ThrowMin3;	//556  44  R      Minimum throw time of switch 3
+    unsigned char ThrowMin4;	//557  45  R      Minimum throw time of switch 4
+    unsigned char ThrowMax1;	//558  46  R      Maximum throw time of switch 1
+    unsigned char ThrowMax2;	//559  47  R      Maximum throw time of switch 2
+    unsigned char ThrowMax3;	//560  48  R      Maximum throw time of switch 3
+    unsigned char ThrowMax4;	//561  49  R      Maximum throw time of switch 4
+                                //                The throw times are kept in RAM by switch.c; read_cv() in
+                                //                cv_pom.c returns them. These EEPROM bytes are placeholders,
+                                //                so that each CV stays at EEPROM address CV-1.
+                                //                Only devices 1..4 have feedback, so there are no throw times
+                                //                for devices 5..8.
+    unsigned char MaxCoils;	//562  50  R/W    Maximum number of coils that are active at the same time. 0 = no limit
+    unsigned char PulseUnit;	//563  51  R/W    Unit of CV3..6: 0 = 20ms ticks / 1..255 = ms (pulse ended with 1ms resolution)
+    unsigned char HoldDuty;	//564  52  R/W    PWM hold after the pull-in pulse: 0 = off / 1..7 = ms on per 8 ms (needs CV51 > 0)
+    unsigned char PullIn;	//565  53  R/W    Pull-in time before PWM hold starts (in CV51 units)
+                                //                Route steps: P = 0, or a device this decoder does not have, only delays.
+    unsigned char Route1AddrL;	//566  54  R/W    Route 1: switch number (1..2048) that triggers the route, low byte. 0 = not used
+    unsigned char Route1AddrH;	//567  55  R/W    Route 1: switch number, high byte (bits 10..8)
+    unsigned char Route1Step1;	//568  56  R/W    Route 1, step 1: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route1Step2;	//569  57  R/W    Route 1, step 2: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route1Step3;	//570  58  R/W    Route 1, step 3: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route1Step4;	//571  59  R/W    Route 1, step 4: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route2AddrL;	//572  60  R/W    Route 2: switch number (1..2048) that triggers the route, low byte. 0 = not used
+    unsigned char Route2AddrH;	//573  61  R/W    Route 2: switch number, high byte (bits 10..8)
+    unsigned char Route2Step1;	//574  62  R/W    Route 2, step 1: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route2Step2;	//575  63  R/W    Route 2, step 2: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route2Step3;	//576  64  R/W    Route 2, step 3: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route2Step4;	//577  65  R/W    Route 2, step 4: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route3AddrL;	//578  66  R/W    Route 3: switch number (1..2048) that triggers the route, low byte. 0 = not used
+    unsigned char Route3AddrH;	//579  67  R/W    Route 3: switch number, high byte (bits 10..8)
+    unsigned char Route3Step1;	//580  68  R/W    Route 3, step 1: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route3Step2;	//581  69  R/W    Route 3, step 2: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route3Step3;	//582  70  R/W    Route 3, step 3: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route3Step4;	//583  71  R/W    Route 3, step 4: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route4AddrL;	//584  72  R/W    Route 4: switch number (1..2048) that triggers the route, low byte. 0 = not used
+    unsigned char Route4AddrH;	//585  73  R/W    Route 4: switch number, high byte (bits 10..8)
+    unsigned char Route4Step1;	//586  74  R/W    Route 4, step 1: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route4Step2;	//587  75  R/W    Route 4, step 2: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route4Step3;	//588  76  R/W    Route 4, step 3: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+    unsigned char Route4Step4;	//589  77  R/W    Route 4, step 4: DDDGPPPP (delay D * 200ms, gate G, device P = 1..8, 0 = none). 0 = no step
+
+    
+ } t_cv_record;
@@ -1,18 +1,30 @@
-//------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder2
-//
-// Copyright (c) 2006 Kufer
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-// 
-//------------------------------------------------------------------------
-//
-// file:      cv_pom.h
-#pragma once
-
-void ResetDecoder(void);
-void cv_operation(unsigned char op_mode);
-void check_PoM_time_out(void);
+//------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder2
+//
+// Copyright (c) 2006 Kufer
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+// 
+//------------------------------------------------------------------------
+//
+// file:      cv_pom.h
+#pragma once
+
+// RAM copy of the CVs that are needed for (nearly) every DCC packet. Reading these from EEPROM
+// for every packet would stall the CPU. Loaded by init_cv_shadow() and updated by cv_operation()
+typedef struct
+  {
+    unsigned char CmdStation;	// CV19: 0 = standard / 1 = Lenz
+    unsigned char SkipUnEven;	// CV21: only even decoder addresses are used
+    unsigned char AlwaysAct;	// CV34: activate coil / relays for each DCC command received
+  } t_cv_shadow;
+
+extern t_cv_shadow cv_shadow;
+
+void init_cv_shadow(void);
+
+void ResetDecoder(void);
+void cv_operation(unsigned char op_mode);
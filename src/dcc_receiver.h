@@ -1,52 +1,109 @@
-//------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder
-//
-// Copyright (c) 2006 Kufer
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-// 
-//------------------------------------------------------------------------
-//
-// file:      dcc_receiver.h
-// author:    Wolfgang Kufer
-// contact:   kufer@gmx.de
-// webpage:   http://www.opendcc.de
-// history:   2006-02-14 V0.1 kw start
-//
-//------------------------------------------------------------------------
-//
-// purpose:   flexible general purpose decoder for dcc
-//
-//------------------------------------------------------------------------
-//
-// howto:     Step 1: call init_dcc_receiver()
-//            Step 2: every time a new message is received, the
-//                    semaphor_set is called with C_Received = 1
-//            Step 3: The host program can now read the message incoming;
-//                    The message must be read within the next
-//                    2ms and must be checked by the host,
-//                    dcc_receiver makes only the physical layer.
-//
-#pragma once
-
-
-#define MAX_DCC_SIZE  6
-typedef struct
-  {
-    unsigned char size;               // 3 .. 6, including XOR
-    unsigned char dcc[MAX_DCC_SIZE];  // the dcc content
-  } t_message;
-
-
-extern t_message incoming;         // here we deliver the incoming message
-
-void init_dcc_receiver(void);
-
-void activate_ACK(unsigned char time);          // make prog or feedback ack
-
-
-// Added by AP             
-volatile unsigned char new_adc_requested;    // Flag to signal new ADC conversion should start 
+//------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder
+//
+// Copyright (c) 2006 Kufer
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+// 
+//------------------------------------------------------------------------
+//
+// file:      dcc_receiver.h
+// author:    Wolfgang Kufer
+// contact:   kufer@gmx.de
+// webpage:   http://www.opendcc.de
+// history:   2006-02-14 V0.1 kw start
+//
+//------------------------------------------------------------------------
+//
+// purpose:   flexible general purpose decoder for dcc
+//
+//------------------------------------------------------------------------
+//
+// howto:     Step 1: call init_dcc_receiver()
+//            Step 2: every time a new message is received, the ISR
+//                    stores it in the next free slot of dcc_ring and
+//                    advances dcc_ring_head.
+//            Step 3: The host program checks dcc_message_available(),
+//                    reads the message via dcc_message_peek() and
+//                    frees the slot with dcc_message_release().
+//                    Up to DCC_RING_SIZE - 1 messages are buffered; the
+//                    message must be checked by the host,
+//                    dcc_receiver makes only the physical layer.
+//
+#pragma once
+
+
+// The receiver comes in two variants; select one at compile time (in the Makefile: RECEIVER=):
+// DCC_RX_SAMPLING:  every rising edge on INT1 starts Timer0; 77us later the Timer0 overflow
+//                   ISR samples the DCC input (two interrupts per bit)
+// DCC_RX_TIMESTAMP: each edge on INT1 reads the free running Timer1. Each half bit is classified
+//                   from the time since the previous edge: shorter than 77us is half a "1",
+//                   longer is half a "0". Two equal halves make a bit (Timer0 is not used).
+//                   Note: the DCC input (PD3) is not the ICP1 pin, so the timestamp is taken in
+//                   software and includes the interrupt latency. The INT0 ISR (RS-bus polling,
+//                   higher priority than INT1), the TC2 ISR (1ms, feedback sampling and coil
+//                   pulses) and the TIMER1_OVF ISR (20ms tick) all delay INT1. The split point
+//                   at 77us allows a difference in latency between two edges of 13us for halves
+//                   at the NMRA limits, and 19us (ones) / 23us (zeros) for a nominal signal: the
+//                   same margin the sampling receiver has around its 77us sample point.
+//                   It needs two interrupts per bit, just as the sampling receiver.
+#define DCC_RX_SAMPLING     0
+#define DCC_RX_TIMESTAMP    1
+
+#ifndef DCC_RECEIVER_MODE
+#define DCC_RECEIVER_MODE   DCC_RX_SAMPLING
+#endif
+
+
+#define MAX_DCC_SIZE  6
+typedef struct
+  {
+    unsigned char size;               // 3 .. 6, including XOR
+    unsigned char dcc[MAX_DCC_SIZE];  // the dcc content
+  } t_message;
+
+
+// Single producer (ISR) / single consumer (main) ring of received messages.
+// Only the ISR writes dcc_ring_head, only main writes dcc_ring_tail. Since both
+// are single bytes, no cli() / sei() is needed to access them.
+#define DCC_RING_SIZE 8                     // must be a power of 2; one slot always stays free
+
+extern t_message dcc_ring[DCC_RING_SIZE];   // here we deliver the incoming messages
+extern volatile unsigned char dcc_ring_head;   // next slot the ISR will fill
+extern volatile unsigned char dcc_ring_tail;   // oldest slot not yet read by main
+
+void init_dcc_receiver(void);
+
+
+static inline unsigned char dcc_message_available(void) 
+       __attribute__((always_inline));
+
+unsigned char dcc_message_available(void)
+  {
+    return (dcc_ring_head != dcc_ring_tail);
+  }
+
+static inline t_message *dcc_message_peek(void) 
+       __attribute__((always_inline));
+
+t_message *dcc_message_peek(void)
+  {
+    return (&dcc_ring[dcc_ring_tail]);
+  }
+
+static inline void dcc_message_release(void) 
+       __attribute__((always_inline));
+
+void dcc_message_release(void)
+  {
+    dcc_ring_tail = (dcc_ring_tail + 1) & (DCC_RING_SIZE - 1);
+  }
+
+void activate_ACK(unsigned char time);          // make prog or feedback ack
+
+
+// Added by AP             
+volatile unsigned char new_adc_requested;    // Flag to signal new ADC conversion should start 
@@ -0,0 +1,22 @@
+//*****************************************************************************************************
+//
+// file:      host/avr/eeprom.h
+// purpose:   Host (x86) replacement for <avr/eeprom.h>
+//            EEPROM variables are normal variables on the host. The access routines in hal_host.c
+//            read and write these variables directly and count the number of write operations.
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define EEMEM
+
+uint8_t eeprom_read_byte(const uint8_t *__p);
+void eeprom_write_byte(uint8_t *__p, uint8_t __value);
+void eeprom_read_block(void *__dst, const void *__src, size_t __n);
+#define eeprom_busy_wait()  do {} while (0)
+#define eeprom_is_ready()   1
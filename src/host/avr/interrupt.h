@@ -0,0 +1,32 @@
+//*****************************************************************************************************
+//
+// file:      host/avr/interrupt.h
+// purpose:   Host (x86) replacement for <avr/interrupt.h>
+//            An ISR becomes a normal function with the name of its vector, for example
+//            ISR(TIMER0_OVF_vect) defines void TIMER0_OVF_vect(void). The simulation routines in
+//            hal_host.c call these functions to "raise" an interrupt.
+//            Interrupts are never nested on the host, so cli() and sei() only record the state.
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdint.h>
+
+extern volatile uint8_t host_interrupts_enabled;
+
+#define ISR(vector, ...)  void vector(void); void vector(void)
+#define sei()             (host_interrupts_enabled = 1)
+#define cli()             (host_interrupts_enabled = 0)
+
+// Vectors of the ATmega16 that are simulated by hal_host.c. They are declared weak, so a vector
+// that the firmware does not use (for example TIMER0_OVF_vect with the timestamp receiver) is
+// simply not called.
+void INT0_vect(void) __attribute__((weak));
+void INT1_vect(void) __attribute__((weak));
+void TIMER0_OVF_vect(void) __attribute__((weak));
+void TIMER1_OVF_vect(void) __attribute__((weak));
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER1_COMPB_vect(void) __attribute__((weak));
+void TIMER2_COMP_vect(void) __attribute__((weak));
@@ -0,0 +1,122 @@
+//*****************************************************************************************************
+//
+// file:      host/avr/io.h
+// purpose:   Host (x86) replacement for <avr/io.h>
+//            Each I/O register of the ATmega16 that is used by the decoder is mapped onto a plain
+//            variable, defined in hal_host.c. The simulation routines in hal_host.c read and write
+//            these variables to emulate the ports, timers and the USART.
+//            Bit positions are copied from the ATmega16 datasheet (iom16.h).
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdint.h>
+
+// Ports
+extern volatile uint8_t PORTA, DDRA, PINA;
+extern volatile uint8_t PORTB, DDRB, PINB;
+extern volatile uint8_t PORTC, DDRC, PINC;
+extern volatile uint8_t PORTD, DDRD, PIND;
+
+// Status register. On the host only the I-bit exists: SREG is the interrupt flag of cli() / sei()
+// (see interrupt.h), so "sreg = SREG; cli(); ... SREG = sreg;" works as on the AVR.
+extern volatile uint8_t host_interrupts_enabled;
+#define SREG    host_interrupts_enabled
+
+// External interrupts
+extern volatile uint8_t GICR, GIFR, MCUCR, MCUCSR;
+#define INT1    7
+#define INT0    6
+#define INT2    5
+#define INTF1   7
+#define INTF0   6
+#define INTF2   5
+#define SM2     7
+#define SE      6
+#define SM1     5
+#define SM0     4
+#define ISC11   3
+#define ISC10   2
+#define ISC01   1
+#define ISC00   0
+
+// Timer interrupt mask and flag registers
+extern volatile uint8_t TIMSK, TIFR;
+#define OCIE2   7
+#define TOIE2   6
+#define TICIE1  5
+#define OCIE1A  4
+#define OCIE1B  3
+#define TOIE1   2
+#define OCIE0   1
+#define TOIE0   0
+#define OCF2    7
+#define TOV2    6
+#define ICF1    5
+#define OCF1A   4
+#define OCF1B   3
+#define TOV1    2
+#define OCF0    1
+#define TOV0    0
+
+// Timer 0
+extern volatile uint8_t TCCR0, TCNT0, OCR0;
+#define FOC0    7
+#define WGM00   6
+#define COM01   5
+#define COM00   4
+#define WGM01   3
+#define CS02    2
+#define CS01    1
+#define CS00    0
+
+// Timer 1
+extern volatile uint8_t TCCR1A, TCCR1B;
+extern volatile uint16_t TCNT1, ICR1, OCR1A, OCR1B;
+#define COM1A1  7
+#define COM1A0  6
+#define COM1B1  5
+#define COM1B0  4
+#define FOC1A   3
+#define FOC1B   2
+#define WGM11   1
+#define WGM10   0
+#define ICNC1   7
+#define ICES1   6
+#define WGM13   4
+#define WGM12   3
+#define CS12    2
+#define CS11    1
+#define CS10    0
+
+// Timer 2
+extern volatile uint8_t TCCR2, TCNT2, OCR2;
+#define FOC2    7
+#define WGM20   6
+#define COM21   5
+#define COM20   4
+#define WGM21   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+
+// USART
+extern volatile uint8_t UDR, UCSRA, UCSRB, UCSRC, UBRRL, UBRRH;
+#define RXC     7
+#define TXC     6
+#define UDRE    5
+#define RXCIE   7
+#define TXCIE   6
+#define UDRIE   5
+#define RXEN    4
+#define TXEN    3
+#define URSEL   7
+#define UCSZ1   2
+#define UCSZ0   1
+
+// ADC (only referenced by GBM specific code)
+extern volatile uint8_t ADCSRA;
+#define ADEN    7
+#define ADSC    6
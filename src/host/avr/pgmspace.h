@@ -0,0 +1,27 @@
+//*****************************************************************************************************
+//
+// file:      host/avr/pgmspace.h
+// purpose:   Host (x86) replacement for <avr/pgmspace.h>
+//            The host has a single address space, so PROGMEM data is read directly.
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define pgm_read_byte(addr)     (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)     host_pgm_read_word(addr)
+#define memcpy_P(dst, src, n)   memcpy((dst), (src), (n))
+
+// Via memcpy, so that words can be read from tables of any 16 bit type
+static inline uint16_t host_pgm_read_word(const void *addr)
+{
+  uint16_t word;
+  memcpy(&word, addr, sizeof(word));
+  return word;
+}
@@ -0,0 +1,18 @@
+//*****************************************************************************************************
+//
+// file:      host/avr/sleep.h
+// purpose:   Host (x86) replacement for <avr/sleep.h>
+//            On the host, ISRs only run from within the host_ routines (see hal_host.h), so
+//            there is nothing to wait for: sleep_cpu() returns immediately.
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+
+#define SLEEP_MODE_IDLE         0
+#define set_sleep_mode(mode)    ((void)(mode))
+#define sleep_enable()          ((void)0)
+#define sleep_disable()         ((void)0)
+#define sleep_cpu()             ((void)0)
@@ -0,0 +1,182 @@
+//*****************************************************************************************************
+//
+// file:      host/dcc_replay.c
+// purpose:   Replay a DCC signal captured with a logic analyser through the DCC receiver and
+//            analyze_message() of the host build
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-16 V0.1 Initial version
+//                       V0.2 Expired software timers are handled (service mode time out)
+//
+// usage:     dcc_replay [-c column] [-r samplerate] [-i] trace.csv
+//            -c column      column with the DCC signal (default 2: the first column after the time)
+//            -r samplerate  the file has no time column; each line is one sample at this rate (Hz)
+//            -i             invert the signal
+//            "make replay TRACE=trace.csv" builds the program and replays the trace
+//
+//*****************************************************************************************************
+//
+// The trace is a CSV file, as exported by sigrok-cli (-O csv) or PulseView. Lines that do not start
+// with a number (headers, comments starting with ";" or "#") are skipped. Each remaining line
+// contains the time in seconds, followed by the logic levels of the channels, for example:
+//   0.000125000,1,0
+// Only level changes matter, so both a sample per line and an edge per line (timestamp,level) work.
+//
+// The signal is connected to the DCCIN pin of the simulated decoder. Between two edges the simulated
+// time runs on, so the timers (and thus the receiver) behave as on the real hardware. After each
+// edge the received messages and expired software timers are handled, just as the main loop of the
+// firmware does.
+// At the end the program reports the number of decoded packets, checksum failures and the speed
+// of the replay (packets per second of host time).
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "global.h"
+#include "config.h"
+#include "dcc_receiver.h"
+#include "dcc_decode.h"
+#include "timer1.h"
+#include "cv_pom.h"
+#include "hal_host.h"
+
+#define LINE_SIZE 1024
+
+static unsigned long packets;                 // packets handed over by the receiver
+static unsigned long cmd_count[SM_CMD + 1];   // per CmdType
+static unsigned long checksum_errors;
+static unsigned char last_quality;
+
+static void handle_messages(void)
+{
+  if (events & (1<<EV_TIMER))
+  {
+    events &= ~(1<<EV_TIMER);
+    run_timers();
+  }
+  while (dcc_message_available())
+  {
+    analyze_message(dcc_message_peek());
+    dcc_message_release();
+    packets++;
+    if (CmdType <= SM_CMD) cmd_count[CmdType]++;
+  }
+  // DccSignalQuality is an 8 bit counter; add the increase since last time
+  checksum_errors += (unsigned char)(DccSignalQuality - last_quality);
+  last_quality = DccSignalQuality;
+}
+
+static double elapsed(struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *trace;
+  char line[LINE_SIZE];
+  int column = 2;
+  double samplerate = 0;
+  int invert = 0;
+  int opt;
+  unsigned long sample = 0, edges = 0;
+  double t, t_first = -1, t_last = 0, host_time;
+  uint64_t cycle;
+  unsigned char level, last_level = 1;
+  struct timespec start;
+
+  for (opt = 1; (opt < argc) && (argv[opt][0] == '-'); opt++)
+  {
+    if (!strcmp(argv[opt], "-c") && (opt + 1 < argc)) column = atoi(argv[++opt]);
+    else if (!strcmp(argv[opt], "-r") && (opt + 1 < argc)) samplerate = atof(argv[++opt]);
+    else if (!strcmp(argv[opt], "-i")) invert = 1;
+    else break;
+  }
+  if ((opt != argc - 1) || (column < 1) || (!samplerate && column < 2))
+  {
+    fprintf(stderr, "usage: %s [-c column] [-r samplerate] [-i] trace.csv\n", argv[0]);
+    return 2;
+  }
+  if (samplerate && column == 2) column = 1;  // without time column the signal is the first one
+  trace = strcmp(argv[opt], "-") ? fopen(argv[opt], "r") : stdin;
+  if (!trace)
+  {
+    perror(argv[opt]);
+    return 2;
+  }
+
+  // Same initialisation as main(), restricted to the DCC part
+  host_reset();
+  init_hardware();
+  init_global();
+  init_cv_shadow();
+  init_dcc_receiver();
+  init_dcc_decode();
+  init_timer1();
+  sei();
+  host_set_input(&PIND, DCCIN, last_level);
+  last_quality = DccSignalQuality;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (fgets(line, sizeof(line), trace))
+  {
+    char *field = line;
+    char *end;
+    int i;
+    if ((line[0] < '0' || line[0] > '9') && line[0] != '.') continue;
+    if (samplerate) t = sample++ / samplerate;
+    else
+    {
+      t = strtod(line, &end);
+      if (end == line) continue;
+    }
+    for (i = 1; (i < column) && field; i++)
+    {
+      field = strchr(field, ',');
+      if (field) field++;
+    }
+    if (!field) continue;
+    level = (atoi(field) != 0) ^ invert;
+    if (t_first < 0) t_first = t;
+    t_last = t;
+    // Let the simulated time run till this sample, then apply a level change
+    cycle = (uint64_t)((t - t_first) * F_CPU);
+    if (cycle > host_cycles) host_advance_cycles(cycle - host_cycles);
+    if (level != last_level)
+    {
+      host_set_input(&PIND, DCCIN, level);
+      last_level = level;
+      edges++;
+      handle_messages();
+    }
+  }
+  host_advance_us(1000);                      // let the receiver finish the last packet
+  handle_messages();
+  host_time = elapsed(&start);
+  if (trace != stdin) fclose(trace);
+
+  printf("trace:              %.3f s, %lu edges\n", (t_first < 0) ? 0 : t_last - t_first, edges);
+  printf("packets decoded:    %lu\n", packets);
+  printf("  accessory (any):  %lu\n", cmd_count[ANY_ACCESSORY_CMD]);
+  printf("  accessory (mine): %lu\n", cmd_count[ACCESSORY_CMD]);
+  printf("  loco F0-F4:       %lu\n", cmd_count[LOCO_F0F4_CMD]);
+  printf("  PoM:              %lu\n", cmd_count[POM_CMD]);
+  printf("checksum failures:  %lu\n", checksum_errors);
+  printf("host time:          %.3f s\n", host_time);
+  if (host_time > 0)
+    printf("throughput:         %.0f packets/s (%.1fx real time)\n",
+           packets / host_time, (t_last - t_first) / host_time);
+  return 0;
+}
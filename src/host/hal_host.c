@@ -0,0 +1,370 @@
+//*****************************************************************************************************
+//
+// file:      host/hal_host.c
+// purpose:   Hardware abstraction layer for running the decoder core on a host (x86) machine
+//            See hal_host.h for an overview
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-16 V0.1 Initial version
+//            2026-10-17 V0.2 host_reset() also clears the position journal; host_power_up() added
+//
+//*****************************************************************************************************
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "global.h"
+#include "config.h"
+#include "hardware.h"
+#include "switch.h"
+#include "hal_host.h"
+
+
+//*****************************************************************************************************
+// Simulated registers
+//*****************************************************************************************************
+volatile uint8_t PORTA, DDRA, PINA;
+volatile uint8_t PORTB, DDRB, PINB;
+volatile uint8_t PORTC, DDRC, PINC;
+volatile uint8_t PORTD, DDRD, PIND;
+volatile uint8_t GICR, GIFR, MCUCR, MCUCSR;
+volatile uint8_t TIMSK, TIFR;
+volatile uint8_t TCCR0, TCNT0, OCR0;
+volatile uint8_t TCCR1A, TCCR1B;
+volatile uint16_t TCNT1, ICR1, OCR1A, OCR1B;
+volatile uint8_t TCCR2, TCNT2, OCR2;
+volatile uint8_t UDR, UCSRA, UCSRB, UCSRC, UBRRL, UBRRH;
+volatile uint8_t ADCSRA;
+
+volatile uint8_t host_interrupts_enabled;
+
+uint64_t host_cycles;
+unsigned long host_eeprom_writes;
+unsigned long host_restarts;
+t_host_rsbus host_rsbus_log[HOST_RSBUS_LOG_SIZE];
+unsigned char host_rsbus_count;
+
+// Pending interrupt flags. The layout is that of GIFR and TIFR
+static uint8_t pending_gifr;
+static uint8_t pending_tifr;
+
+// Cycles that passed since the last increment of each timer (prescaler state)
+static uint16_t t0_acc, t1_acc, t2_acc;
+
+
+//*****************************************************************************************************
+// EEPROM
+//*****************************************************************************************************
+uint8_t eeprom_read_byte(const uint8_t *__p)
+{
+  return *__p;
+}
+
+void eeprom_write_byte(uint8_t *__p, uint8_t __value)
+{
+  *__p = __value;
+  host_eeprom_writes++;
+}
+
+void eeprom_read_block(void *__dst, const void *__src, size_t __n)
+{
+  memcpy(__dst, __src, __n);
+}
+
+
+//*****************************************************************************************************
+// Interrupts
+//*****************************************************************************************************
+static void call_vector(void (*vector)(void))
+{
+  if (vector == 0) return;                    // The firmware does not use this interrupt
+  host_interrupts_enabled = 0;                // The AVR clears the I-bit when entering an ISR
+  vector();
+  host_interrupts_enabled = 1;                // RETI
+}
+
+static void service_interrupts(void)
+{
+  uint8_t again = 1;
+  while (again)
+  {
+    // Write-one-to-clear: bits the firmware wrote into GIFR / TIFR clear the pending flags
+    pending_gifr &= ~GIFR; GIFR = 0;
+    pending_tifr &= ~TIFR; TIFR = 0;
+    if (!host_interrupts_enabled) return;
+    again = 1;
+    // Same priority as the vector table of the ATmega16
+    if ((pending_gifr & (1<<INTF0)) && (GICR & (1<<INT0)))
+      {pending_gifr &= ~(1<<INTF0); call_vector(INT0_vect);}
+    else if ((pending_gifr & (1<<INTF1)) && (GICR & (1<<INT1)))
+      {pending_gifr &= ~(1<<INTF1); call_vector(INT1_vect);}
+    else if ((pending_tifr & (1<<OCF2)) && (TIMSK & (1<<OCIE2)))
+      {pending_tifr &= ~(1<<OCF2); call_vector(TIMER2_COMP_vect);}
+    else if ((pending_tifr & (1<<OCF1A)) && (TIMSK & (1<<OCIE1A)))
+      {pending_tifr &= ~(1<<OCF1A); call_vector(TIMER1_COMPA_vect);}
+    else if ((pending_tifr & (1<<OCF1B)) && (TIMSK & (1<<OCIE1B)))
+      {pending_tifr &= ~(1<<OCF1B); call_vector(TIMER1_COMPB_vect);}
+    else if ((pending_tifr & (1<<TOV1)) && (TIMSK & (1<<TOIE1)))
+      {pending_tifr &= ~(1<<TOV1); call_vector(TIMER1_OVF_vect);}
+    else if ((pending_tifr & (1<<TOV0)) && (TIMSK & (1<<TOIE0)))
+      {pending_tifr &= ~(1<<TOV0); call_vector(TIMER0_OVF_vect);}
+    else again = 0;
+  }
+}
+
+
+//*****************************************************************************************************
+// Timers
+//*****************************************************************************************************
+static uint16_t prescaler_t01(uint8_t cs)
+{
+  switch (cs & 7)
+  {
+    case 1: return 1;
+    case 2: return 8;
+    case 3: return 64;
+    case 4: return 256;
+    case 5: return 1024;
+    default: return 0;                        // stopped, or external clock (not simulated)
+  }
+}
+
+static uint16_t prescaler_t2(uint8_t cs)
+{
+  static const uint16_t table[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+  return table[cs & 7];
+}
+
+static uint16_t timer1_top(void)
+{
+  // Only mode 0 (normal) and mode 14 (fast PWM, TOP = ICR1) are used by the decoder
+  if ((TCCR1B & (1<<WGM13)) && (TCCR1B & (1<<WGM12))) return ICR1;
+  return 0xFFFF;
+}
+
+// Number of timer ticks till the next event of each timer
+static uint32_t t0_ticks_to_event(void)
+{
+  return 256 - TCNT0;
+}
+
+static uint32_t t1_ticks_to_event(void)
+{
+  uint32_t top = timer1_top();
+  uint32_t ticks = top + 1 - TCNT1;
+  if ((OCR1A > TCNT1) && (OCR1A - TCNT1 < ticks)) ticks = OCR1A - TCNT1;
+  if ((OCR1B > TCNT1) && (OCR1B - TCNT1 < ticks)) ticks = OCR1B - TCNT1;
+  return ticks;
+}
+
+static uint32_t t2_ticks_to_event(void)
+{
+  if ((TCCR2 & (1<<WGM21)) && (TCNT2 <= OCR2)) return OCR2 + 1 - TCNT2;
+  return 256 - TCNT2;
+}
+
+static uint64_t cycles_to_event(uint16_t prescaler, uint16_t acc, uint32_t ticks)
+{
+  return (uint64_t)ticks * prescaler - acc;
+}
+
+static void step_timers(uint64_t cycles)
+{
+  uint16_t p;
+  uint32_t ticks, count;
+  // Timer 0: normal mode
+  if ((p = prescaler_t01(TCCR0)))
+  {
+    ticks = (t0_acc + cycles) / p;
+    t0_acc = (t0_acc + cycles) % p;
+    count = TCNT0 + ticks;
+    if (count >= 256) pending_tifr |= (1<<TOV0);
+    TCNT0 = count;
+  }
+  // Timer 1: compare A and B, overflow at TOP
+  if ((p = prescaler_t01(TCCR1B)))
+  {
+    ticks = (t1_acc + cycles) / p;
+    t1_acc = (t1_acc + cycles) % p;
+    count = TCNT1 + ticks;
+    if ((TCNT1 < OCR1A) && (count >= OCR1A)) pending_tifr |= (1<<OCF1A);
+    if ((TCNT1 < OCR1B) && (count >= OCR1B)) pending_tifr |= (1<<OCF1B);
+    if (count > timer1_top())
+    {
+      count = 0;
+      pending_tifr |= (1<<TOV1);
+      if (OCR1A == 0) pending_tifr |= (1<<OCF1A);
+      if (OCR1B == 0) pending_tifr |= (1<<OCF1B);
+    }
+    TCNT1 = count;
+  }
+  // Timer 2: CTC mode clears the counter after a match with OCR2
+  if ((p = prescaler_t2(TCCR2)))
+  {
+    ticks = (t2_acc + cycles) / p;
+    t2_acc = (t2_acc + cycles) % p;
+    count = TCNT2 + ticks;
+    if ((TCCR2 & (1<<WGM21)) && (TCNT2 <= OCR2) && (count > OCR2))
+    {
+      count = 0;
+      pending_tifr |= (1<<OCF2);
+    }
+    TCNT2 = count;
+  }
+}
+
+void host_advance_cycles(uint64_t cycles)
+{
+  uint64_t end = host_cycles + cycles;
+  uint64_t step, next;
+  uint16_t p;
+  service_interrupts();
+  while (host_cycles < end)
+  {
+    // Move forward till the first timer event, so that no compare match gets lost
+    step = end - host_cycles;
+    if ((p = prescaler_t01(TCCR0)))
+      {next = cycles_to_event(p, t0_acc, t0_ticks_to_event()); if (next < step) step = next;}
+    if ((p = prescaler_t01(TCCR1B)))
+      {next = cycles_to_event(p, t1_acc, t1_ticks_to_event()); if (next < step) step = next;}
+    if ((p = prescaler_t2(TCCR2)))
+      {next = cycles_to_event(p, t2_acc, t2_ticks_to_event()); if (next < step) step = next;}
+    if (step == 0) step = 1;
+    step_timers(step);
+    host_cycles += step;
+    service_interrupts();
+  }
+}
+
+void host_advance_us(unsigned long us)
+{
+  host_advance_cycles((uint64_t)us * F_CPU / 1000000UL);
+}
+
+
+//*****************************************************************************************************
+// Input pins and external interrupts
+//*****************************************************************************************************
+static void external_edge(uint8_t isc, uint8_t old_level, uint8_t new_level, uint8_t flag)
+{
+  // isc: the two Interrupt Sense Control bits of this interrupt
+  switch (isc & 3)
+  {
+    case 0: if (new_level == 0) pending_gifr |= flag; break;         // low level
+    case 1: pending_gifr |= flag; break;                             // any change
+    case 2: if (old_level && !new_level) pending_gifr |= flag; break; // falling edge
+    case 3: if (!old_level && new_level) pending_gifr |= flag; break; // rising edge
+  }
+}
+
+void host_set_input(volatile uint8_t *pin, uint8_t bit, uint8_t level)
+{
+  uint8_t old_level = (*pin >> bit) & 1;
+  level = (level != 0);
+  if (level) *pin |= (1 << bit);
+    else *pin &= ~(1 << bit);
+  if (level == old_level) return;
+  if (pin == &PIND)
+  {
+    if (bit == 2) external_edge(MCUCR >> ISC00, old_level, level, (1<<INTF0));
+    if (bit == 3) external_edge(MCUCR >> ISC10, old_level, level, (1<<INTF1));
+  }
+  service_interrupts();
+}
+
+
+//*****************************************************************************************************
+// DCC signal
+//*****************************************************************************************************
+#define DCC_HALF_1  58                        // us
+#define DCC_HALF_0  100                       // us
+
+void host_dcc_bit(unsigned char bit)
+{
+  unsigned long half = bit ? DCC_HALF_1 : DCC_HALF_0;
+  host_set_input(&PIND, 3, 1);
+  host_advance_us(half);
+  host_set_input(&PIND, 3, 0);
+  host_advance_us(half);
+}
+
+void host_dcc_packet(const unsigned char *data, unsigned char size)
+{
+  unsigned char i, j;
+  for (i = 0; i < 14; i++) host_dcc_bit(1);   // preamble
+  for (i = 0; i < size; i++)
+  {
+    host_dcc_bit(0);                          // start bit of each byte
+    for (j = 0; j < 8; j++) host_dcc_bit((data[i] >> (7 - j)) & 1);
+  }
+  host_dcc_bit(1);                            // packet end bit
+}
+
+
+//*****************************************************************************************************
+// RS-bus
+//*****************************************************************************************************
+void host_rsbus_cycle(void)
+{
+  unsigned char address;
+  // The master sends 130 pulses (addresses 0 .. 129). The decoder reacts on the falling edge.
+  // UDR is cleared before each pulse; a non-zero value afterwards is a byte sent by the decoder.
+  for (address = 0; address < 130; address++)
+  {
+    UDR = 0;
+    host_set_input(&PIND, 2, 1);
+    host_advance_us(100);
+    host_set_input(&PIND, 2, 0);
+    if ((UDR != 0) && (host_rsbus_count < HOST_RSBUS_LOG_SIZE))
+    {
+      host_rsbus_log[host_rsbus_count].address = address;
+      host_rsbus_log[host_rsbus_count].data = UDR;
+      host_rsbus_count++;
+    }
+    host_advance_us(100);
+  }
+  host_set_input(&PIND, 2, 1);
+  host_advance_us(7000);                      // idle period between two polling cycles
+}
+
+
+//*****************************************************************************************************
+// Reset
+//*****************************************************************************************************
+void host_restart(void)
+{
+  host_restarts++;
+}
+
+void host_power_up(void)
+{
+  PORTA = DDRA = PORTB = DDRB = PORTC = DDRC = PORTD = DDRD = 0;
+  PINA = PINB = PINC = PIND = 0xFF;           // all inputs pulled up (program button released)
+  GICR = GIFR = MCUCR = MCUCSR = 0;
+  TIMSK = TIFR = 0;
+  TCCR0 = TCNT0 = OCR0 = 0;
+  TCCR1A = TCCR1B = 0;
+  TCNT1 = ICR1 = OCR1A = OCR1B = 0;
+  TCCR2 = TCNT2 = OCR2 = 0;
+  UDR = UCSRA = UCSRB = UCSRC = UBRRL = UBRRH = 0;
+  ADCSRA = 0;
+  host_interrupts_enabled = 0;
+  pending_gifr = pending_tifr = 0;
+  t0_acc = t1_acc = t2_acc = 0;
+  host_cycles = 0;
+  host_restarts = 0;
+  host_rsbus_count = 0;
+}
+
+void host_reset(void)
+{
+  host_power_up();
+  host_eeprom_writes = 0;
+  memcpy(&CV, &CV_PRESET, sizeof(CV));        // EEPROM contents after "make flash"
+  memset(journal, 0, sizeof(journal));        // the .eep file has no positions (switch.c)
+}
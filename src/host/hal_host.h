@@ -0,0 +1,87 @@
+//*****************************************************************************************************
+//
+// file:      host/hal_host.h
+// purpose:   Hardware abstraction layer for running the decoder core on a host (x86) machine
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-16 V0.1 Initial version
+//            2026-10-17 V0.2 host_reset() also clears the position journal; host_power_up() added
+//
+//*****************************************************************************************************
+//
+// "make host" compiles the firmware sources with -DHOST_BUILD and with the include directory host/
+// in front of the normal search path. The headers in host/avr and host/util replace those of
+// avr-libc; every I/O register becomes a normal variable. This file, together with hal_host.c,
+// simulates the hardware behind these registers:
+// - Simulated ports:  PINA..PIND are set by the test program; PORTA..PORTD are read back.
+//                     host_set_input() also raises INT0 (RS-bus) and INT1 (DCC) on the
+//                     configured edge.
+// - Simulated timers: Timer0, Timer1 (mode 14, TOP = ICR1, compare A and B) and Timer2 (CTC)
+//                     count CPU cycles. host_advance_cycles() / host_advance_us() move time
+//                     forward and call the timer ISRs at the right moments.
+// - Simulated EEPROM: EEMEM variables are normal variables. host_reset() copies CV_PRESET into
+//                     CV and clears the position journal, just as "make flash" loads the .eep
+//                     file. Each test thus starts without the positions of the previous one.
+//                     host_power_up() keeps the EEPROM, as after a power cycle.
+// ISRs are called only if the global interrupt flag (sei) and their enable bit are set.
+// Interrupts never nest on the host, and ISRs only run from within the host_ routines below.
+// The interrupt flags are kept inside hal_host.c. Just as on the AVR, the firmware clears a
+// pending flag by writing a one to GIFR or TIFR; all other bits it writes are ignored.
+//
+// Note on linking: the ISR vectors are weak symbols (see host/avr/interrupt.h). The test program
+// should therefore call the init routines of the modules it uses (init_dcc_receiver() etc.), so
+// that the linker takes these modules from libopendecoder.a.
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdint.h>
+
+// Simulated time, in CPU cycles (F_CPU) since host_reset()
+extern uint64_t host_cycles;
+
+// Number of EEPROM write operations since host_reset() (to check EEPROM wear)
+extern unsigned long host_eeprom_writes;
+
+// Number of times the firmware called _restart(). On the host, execution simply continues.
+extern unsigned long host_restarts;
+
+// Bytes sent over the RS-bus during host_rsbus_cycle()
+#define HOST_RSBUS_LOG_SIZE 64
+typedef struct
+  {
+    unsigned char address;            // RS-bus address that was polled
+    unsigned char data;               // Byte written into UDR
+  } t_host_rsbus;
+extern t_host_rsbus host_rsbus_log[HOST_RSBUS_LOG_SIZE];
+extern unsigned char host_rsbus_count;
+
+// Firmware routines from main.c (main() itself is renamed to firmware_main() on the host)
+void init_hardware(void);
+void init_global(void);
+
+// Power-on reset: clear all registers and simulated time, load the default EEPROM contents
+void host_reset(void);
+
+// Power-on reset that keeps the EEPROM contents (and host_eeprom_writes): power down and up again
+void host_power_up(void);
+
+// Called by _restart() (config.h)
+void host_restart(void);
+
+// Move simulated time forward and call the timer ISRs that become due
+void host_advance_cycles(uint64_t cycles);
+void host_advance_us(unsigned long us);
+
+// Change an input pin. If pin / bit is INT0 (PD2) or INT1 (PD3), the external interrupt is raised
+// if the level change matches the configured edge
+void host_set_input(volatile uint8_t *pin, uint8_t bit, uint8_t level);
+
+// DCC signal on the DCCIN pin. A bit consists of a high and a low half
+void host_dcc_bit(unsigned char bit);
+void host_dcc_packet(const unsigned char *data, unsigned char size);   // data includes the XOR byte
+
+// One complete RS-bus polling cycle (130 pulses of 200us, followed by 7ms silence).
+// Bytes the decoder sends are appended to host_rsbus_log
+void host_rsbus_cycle(void);
@@ -0,0 +1,97 @@
+//*****************************************************************************************************
+//
+// file:      host/host_test.h
+// purpose:   Common code for the host test programs (host/test_*.c)
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-16 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// "make hosttest" builds each host/test_*.c against the host library and runs it. A test program
+// checks its results with CHECK(); it prints each failure and returns the number of failures, so
+// make stops at the first test program that fails.
+// host_main_loop() does the work of the main loop of the firmware for the events that are set, and
+// host_run_us() / host_run_rsbus_cycle() move time forward while doing so, just as the firmware
+// would handle its events between interrupts.
+//
+//*****************************************************************************************************
+#pragma once
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "global.h"
+#include "config.h"
+#include "switch.h"
+#include "switch_feedback.h"
+#include "timer1.h"
+#include "hal_host.h"
+
+static unsigned int host_test_failures;
+
+#define CHECK(cond, ...)                                                    \
+  do {                                                                      \
+    if (!(cond)) {                                                          \
+      host_test_failures++;                                                 \
+      printf("%s:%d: FAILED: ", __FILE__, __LINE__);                        \
+      printf(__VA_ARGS__);                                                  \
+      printf("\n");                                                         \
+    }                                                                       \
+  } while (0)
+
+// Prints the result of the test program; its return value is the exit code
+static inline int host_test_result(const char *name)
+{
+  if (host_test_failures) printf("%s: %u check(s) FAILED\n", name, host_test_failures);
+    else printf("%s: ok\n", name);
+  return (host_test_failures != 0);
+}
+
+// Handle the events set by the ISRs, in the same order as main() (without DCC and the button)
+static inline void host_main_loop(void)
+{
+  unsigned char ev;
+  cli();
+  ev = events;
+  events = 0;
+  sei();
+  if (ev & (1<<EV_TIMER)) run_timers();
+  if (Have_Feedback && (ev & (1<<EV_FEEDBACK))) send_switch_feedback();
+  if (ev & (1<<EV_PULSE)) start_queued_coils();
+}
+
+// Move time forward in steps of 50us, and handle the events in between
+static inline void host_run_us(unsigned long us)
+{
+  unsigned long t;
+  for (t = 0; t < us; t += 50)
+  {
+    host_main_loop();
+    host_advance_us(50);
+  }
+}
+
+// Same as host_rsbus_cycle(), but with the main loop running during the cycle
+static inline void host_run_rsbus_cycle(void)
+{
+  unsigned char address;
+  for (address = 0; address < 130; address++)
+  {
+    UDR = 0;
+    host_set_input(&PIND, 2, 1);
+    host_run_us(100);
+    host_set_input(&PIND, 2, 0);
+    if ((UDR != 0) && (host_rsbus_count < HOST_RSBUS_LOG_SIZE))
+    {
+      host_rsbus_log[host_rsbus_count].address = address;
+      host_rsbus_log[host_rsbus_count].data = UDR;
+      host_rsbus_count++;
+    }
+    host_run_us(100);
+  }
+  host_set_input(&PIND, 2, 1);
+  host_run_us(7000);
+}
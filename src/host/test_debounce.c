@@ -0,0 +1,123 @@
+//*****************************************************************************************************
+//
+// file:      host/test_debounce.c
+// purpose:   Host test of the feedback debouncer (vertical counter, switch_feedback.c)
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// For each debounce depth (CV35 = 1..8) a long random sequence of samples is fed into
+// sample_feedbacks(). After each sample, fb_level and fb_stable must equal those of a simple
+// reference: per signal the number of equal samples in a row, which must be at least the depth.
+// Just like the firmware after a restart, the reference starts as if the signals just went to 0.
+// Also a changed debounce depth (CV35 written while running) must keep the signals that are stable.
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "cv_pom.h"
+#include "host_test.h"
+
+#define SAMPLES 100000L
+
+extern volatile unsigned char fb_level;
+extern volatile unsigned char fb_stable;
+
+static unsigned char ref_level;               // last sample
+static unsigned int ref_run[8];               // number of equal samples in a row, per signal
+
+static void ref_sample(unsigned char sample)
+{
+  unsigned char i;
+  for (i = 0; i < 8; i++)
+  {
+    if (((sample ^ ref_level) >> i) & 1) ref_run[i] = 1;
+      else ref_run[i]++;
+  }
+  ref_level = sample;
+}
+
+static unsigned char ref_stable(unsigned char depth)
+{
+  unsigned char i, stable = 0;
+  for (i = 0; i < 8; i++) {if (ref_run[i] >= depth) stable |= (1 << i);}
+  return(stable);
+}
+
+// Random sample: each signal changes with a chance of 1 in 2^bounce, so that both short bursts
+// and long stable periods occur
+static unsigned char next_sample(unsigned char sample, unsigned char bounce)
+{
+  unsigned char i;
+  for (i = 0; i < 8; i++) {if ((rand() & ((1 << bounce) - 1)) == 0) sample ^= (1 << i);}
+  return(sample);
+}
+
+static void start(unsigned char depth)
+{
+  unsigned char i;
+  host_reset();
+  CV.FBDebounce = depth;
+  init_hardware();
+  init_global();
+  init_switch_feedback();
+  ref_level = 0;
+  for (i = 0; i < 8; i++) ref_run[i] = 1;
+}
+
+int main(void)
+{
+  unsigned char depth, bounce, sample, stable_seen, all_stable;
+  long n;
+
+  srand(1);
+  for (depth = 1; depth <= 8; depth++)
+  {
+    start(depth);
+    stable_seen = 0;
+    sample = 0;
+    for (n = 0; n < SAMPLES; n++)
+    {
+      bounce = 1 + (n / 1000) % 5;            // vary the amount of bouncing
+      sample = next_sample(sample, bounce);
+      FEEDBACK_IN = sample;
+      sample_feedbacks();
+      ref_sample(sample);
+      CHECK(fb_level == sample, "depth %u sample %ld: fb_level %02x, expected %02x", depth, n, fb_level, sample);
+      CHECK(fb_stable == ref_stable(depth), "depth %u sample %ld: fb_stable %02x, expected %02x",
+            depth, n, fb_stable, ref_stable(depth));
+      stable_seen |= fb_stable;
+      if (host_test_failures > 20) return host_test_result("test_debounce");
+    }
+    CHECK(stable_seen == 0xFF, "depth %u: not all signals were ever stable (%02x)", depth, stable_seen);
+  }
+
+  // CV35 written while running: stable signals stay stable, a changing signal needs the new depth
+  start(2);
+  FEEDBACK_IN = 0x0F;
+  for (n = 0; n < 4; n++) sample_feedbacks();
+  all_stable = fb_stable;
+  CHECK(all_stable == 0xFF, "depth 2: stable %02x after 4 equal samples", all_stable);
+  CV.FBDebounce = 6;
+  init_feedback_sampling();
+  CHECK(fb_stable == 0xFF, "stable %02x after changing CV35", fb_stable);
+  FEEDBACK_IN = 0x0E;
+  for (n = 1; n < 6; n++)
+  {
+    sample_feedbacks();
+    CHECK(!(fb_stable & 0x01), "depth 6: signal 0 stable after %ld samples", n);
+  }
+  sample_feedbacks();
+  CHECK(fb_stable == 0xFF, "depth 6: stable %02x after 6 samples", fb_stable);
+
+  return host_test_result("test_debounce");
+}
@@ -0,0 +1,155 @@
+//*****************************************************************************************************
+//
+// file:      host/test_decode.c
+// purpose:   Host test of the basic accessory address match (acc_match, dcc_decode.c)
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// For all basic accessory commands (dcc[0] = 10AAAAAA, dcc[1] = 1AAACDDD), for both values of
+// CmdStation (CV19) and SkipUnEven (CV21) and for many decoder addresses, the command type and
+// TargetDevice must equal those of the range check that was used before the match table.
+// Broadcasts must address the port in the command, and a PoM write of CV21 must change the match.
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "dcc_receiver.h"
+#include "dcc_decode.h"
+#include "cv_pom.h"
+#include "host_test.h"
+
+// The range check of the decoder before the match table was introduced
+static unsigned char reference(unsigned char dcc0, unsigned char dcc1, unsigned int *device)
+{
+  unsigned int addr = (dcc0 & 0x3F) | ((~dcc1 & 0x70) << 2);
+  unsigned char port = (dcc1 & 0x06) >> 1;
+  unsigned int global, first, last;
+  if (CV.CmdStation == 1)
+  {
+    if (addr == 0) addr = 64;
+    else if (addr == 64) addr = 128;
+    else if (addr == 128) addr = 192;
+    else if (addr == 192) addr = 256;
+    addr--;
+  }
+  global = addr * 4 + port;
+  first = My_Dec_Addr * 4;
+  if (CV.SkipUnEven == 1) last = first + (NUMBER_OF_DEVICES - 1) * 2 + 1;
+    else last = first + NUMBER_OF_DEVICES - 1;
+  if (addr < My_Dec_Addr) return(ANY_ACCESSORY_CMD);
+  if (CV.SkipUnEven == 1) *device = (addr - My_Dec_Addr) * 2 + (port >> 1);
+    else *device = (addr - My_Dec_Addr) * 4 + port;
+  if ((global >= first) && (global <= last)) return(ACCESSORY_CMD);
+  return(ANY_ACCESSORY_CMD);
+}
+
+static unsigned char decode(unsigned char dcc0, unsigned char dcc1)
+{
+  t_message m = {.size = 3, .dcc = {dcc0, dcc1, dcc0 ^ dcc1}};
+  analyze_message(&m);
+  return(CmdType);
+}
+
+static void set_address(unsigned int address, unsigned char cmd_station, unsigned char skip)
+{
+  // CV1 / CV9 as DoProgramming() would store them for this decoder address
+  CV.myAddrL = (address + 1) & 0x3F;
+  CV.myAddrH = ((address + 1) >> 6) & 0x07;
+  CV.CmdStation = cmd_station;
+  CV.SkipUnEven = skip;
+  init_global();
+  init_cv_shadow();
+  init_dcc_decode();
+}
+
+// PoM write (second transmission of the same command) to the decoder
+static void pom_write(unsigned int cv, unsigned char value)
+{
+  unsigned char i;
+  for (i = 0; i < 2; i++)
+  {
+    RecCvNumber = cv - 1;
+    RecCvData = value;
+    RecCvOperation = CV_WRITE;
+    cv_operation(POM_CMD);
+  }
+}
+
+int main(void)
+{
+  static const unsigned int addresses[] = {0, 1, 2, 3, 62, 63, 64, 65, 100, 127, 128, 129, 191, 192,
+                                           193, 254, 255, 256, 300, 383, 384, 447, 448, 508, 509, 510};
+  unsigned int a, device, addr, compared = 0;
+  unsigned char cmd_station, skip, dcc0, dcc1, expect;
+
+  host_reset();
+  init_hardware();
+  init_dcc_receiver();
+  init_timer1();
+
+  // Step 1: all commands, compared with the range check
+  for (cmd_station = 0; cmd_station <= 1; cmd_station++)
+    for (skip = 0; skip <= 1; skip++)
+      for (a = 0; a < sizeof(addresses) / sizeof(addresses[0]); a++)
+      {
+        set_address(addresses[a], cmd_station, skip);
+        CHECK(My_Dec_Addr == addresses[a], "decoder address %u, got %u", addresses[a], My_Dec_Addr);
+        for (dcc0 = 0x80; dcc0 <= 0xBF; dcc0++)
+          for (dcc1 = 0x80; dcc1 >= 0x80; dcc1++)
+          {
+            addr = (dcc0 & 0x3F) | ((~dcc1 & 0x70) << 2);
+            if (addr == 0x1FF) continue;                // broadcast, see step 2
+            device = 0xFFFF;
+            expect = reference(dcc0, dcc1, &device);
+            decode(dcc0, dcc1);
+            compared++;
+            CHECK(CmdType == expect, "CV19=%u CV21=%u decoder %u: %02x %02x gives type %u, expected %u",
+                  cmd_station, skip, My_Dec_Addr, dcc0, dcc1, CmdType, expect);
+            if ((CmdType == ACCESSORY_CMD) && (expect == ACCESSORY_CMD))
+              CHECK(TargetDevice == device, "CV19=%u CV21=%u decoder %u: %02x %02x gives device %u, expected %u",
+                    cmd_station, skip, My_Dec_Addr, dcc0, dcc1, TargetDevice, device);
+            if (host_test_failures > 20) return host_test_result("test_decode");
+          }
+      }
+  printf("test_decode: %u commands compared with the range check\n", compared);
+
+  // Step 2: a broadcast (address 511, not corrected for Lenz) addresses the port in the command
+  for (skip = 0; skip <= 1; skip++)
+  {
+    set_address(100, 0, skip);
+    for (dcc1 = 0x88; dcc1 <= 0x8F; dcc1++)
+    {
+      TargetDevice = 0xFF;
+      decode(0xBF, dcc1);
+      device = (dcc1 & 0x06) >> 1;
+      if (skip) device = device >> 1;
+      CHECK(CmdType == ACCESSORY_CMD, "broadcast CV21=%u: type %u", skip, CmdType);
+      CHECK(TargetDevice == device, "broadcast CV21=%u port %u: device %u, expected %u",
+            skip, (dcc1 & 0x06) >> 1, TargetDevice, device);
+    }
+  }
+
+  // Step 3: a PoM write of CV21 changes the match. The first address after those of the decoder
+  // (with 4 devices: 101) is ours only with SkipUnEven; its port 0 is then device 2 (8 devices: 4)
+  set_address(100, 0, 0);
+  addr = 100 + (NUMBER_OF_DEVICES + 3) / 4;
+  device = ((NUMBER_OF_DEVICES + 3) / 4) * 2;
+  dcc0 = 0x80 | (addr & 0x3F);
+  dcc1 = 0x80 | ((~(addr >> 6) & 0x07) << 4) | 0x08;
+  CHECK(decode(dcc0, dcc1) == ANY_ACCESSORY_CMD, "address %u with CV21=0: type %u", addr, CmdType);
+  pom_write(21, 1);
+  CHECK(CV.SkipUnEven == 1, "PoM write of CV21 not stored");
+  CHECK(decode(dcc0, dcc1) == ACCESSORY_CMD, "address %u after PoM CV21=1: type %u", addr, CmdType);
+  CHECK(TargetDevice == device, "address %u after PoM CV21=1: device %u, expected %u", addr, TargetDevice, device);
+
+  return host_test_result("test_decode");
+}
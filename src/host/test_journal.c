@@ -0,0 +1,156 @@
+//*****************************************************************************************************
+//
+// file:      host/test_journal.c
+// purpose:   Host test of the position journal in EEPROM: restore, power loss and EEPROM wear
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// The positions are changed many times, such that the ring of journal entries wraps around more
+// than twice (and the 8 bit sequence number wraps as well). It is checked that:
+// - each position change writes one entry (JOURNAL_STATE_BYTES + 1 bytes), and that all entries,
+//   thus all EEPROM cells, are written equally often (host_eeprom_writes)
+// - after power-up all positions are restored
+// - if power fails while an entry is being written, the positions before that change are restored
+// A restored position is recognised by a command for that position (with AlwaysAct = 0): the
+// device is already there, so no coil is switched on.
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "config.h"
+#include "global.h"
+#include "hardware.h"
+#include "rs_bus_hardware.h"
+#include "cv_pom.h"
+#include "switch.h"
+#include "host_test.h"
+
+#define CHANGES ((unsigned int) (2 * JOURNAL_SIZE + 50))
+
+static unsigned char position[NUMBER_OF_DEVICES];	// expected position (gate) of each device
+static unsigned long entry_writes[JOURNAL_SIZE];	// EEPROM writes per journal entry
+extern unsigned int journal_head;
+
+static void start(void)
+{
+  init_hardware();
+  init_global();
+  init_cv_shadow();
+  init_timer1();
+  init_RS_hardware();
+  init_switches();
+  sei();
+  host_run_us(100000);				// the restart is over
+}
+
+static void power_up(void)
+{
+  host_power_up();
+  start();
+}
+
+static unsigned char coils_on(void)
+{
+#if (NUMBER_OF_DEVICES > 4)
+  return((OUTPUT_PORT | EXTENSION_PORT) != 0);
+#else
+  return(OUTPUT_PORT != 0);
+#endif
+}
+
+// Returns 1 if the command switched a coil on
+static unsigned char command(unsigned char device, unsigned char gate)
+{
+  TargetDevice = device;
+  TargetGate = gate;
+  TargetActivate = 1;
+  set_switch();
+  return(coils_on());
+}
+
+// Change the position of a device, and wait till the journal has been written
+static void change(unsigned char device)
+{
+  unsigned long writes = host_eeprom_writes;
+  position[device] = !position[device];
+  CHECK(command(device, position[device]), "device %u: no coil switched on", device + 1);
+  host_run_us(300000);
+  entry_writes[journal_head] += host_eeprom_writes - writes;
+}
+
+// After power-up, all devices should be in their expected position
+static void check_restored(const char *when)
+{
+  unsigned char device;
+  for (device = 0; device < NUMBER_OF_DEVICES; device++)
+  {
+    CHECK(!command(device, position[device]), "%s: position of device %u not restored", when, device + 1);
+    host_run_us(300000);
+  }
+}
+
+int main(void)
+{
+  unsigned int i;
+  unsigned long writes, min, max;
+  unsigned char step;
+
+  host_reset();
+  CV.AlwaysAct = 0;				// a command for the current position does nothing
+  CV.MaxCoils = 0;
+  start();
+  for (i = 0; i < NUMBER_OF_DEVICES; i++) change(i);
+
+  // Wrap-around: all entries are written equally often
+  for (i = 0; i < JOURNAL_SIZE; i++) entry_writes[i] = 0;
+  writes = host_eeprom_writes;
+  for (i = 0; i < CHANGES; i++) change(i % NUMBER_OF_DEVICES);
+  writes = host_eeprom_writes - writes;
+  min = max = entry_writes[0];
+  for (i = 1; i < JOURNAL_SIZE; i++)
+  {
+    if (entry_writes[i] < min) min = entry_writes[i];
+    if (entry_writes[i] > max) max = entry_writes[i];
+  }
+  printf("test_journal: %u entries, %u changes: %lu writes, %lu..%lu writes per cell\n", (unsigned int) JOURNAL_SIZE,
+         CHANGES, writes, min / (JOURNAL_STATE_BYTES + 1), max / (JOURNAL_STATE_BYTES + 1));
+  CHECK(writes == (unsigned long) CHANGES * (JOURNAL_STATE_BYTES + 1), "%lu writes for %u changes", writes, CHANGES);
+  CHECK(max == ((CHANGES + JOURNAL_SIZE - 1) / JOURNAL_SIZE) * (JOURNAL_STATE_BYTES + 1),
+        "an entry is written %lu times", max);
+  CHECK(min == (CHANGES / JOURNAL_SIZE) * (JOURNAL_STATE_BYTES + 1), "an entry is written %lu times", min);
+  power_up();
+  check_restored("after wrap-around");
+
+  // Power fails after 1 .. JOURNAL_STATE_BYTES bytes of the entry have been written. First all
+  // entries are filled with device 1 in the position of the interrupted change; only the latest
+  // entry has the position before that change. Thus the old contents of the entry that is being
+  // written would restore the wrong position.
+  change(0);
+  for (i = 0; i < JOURNAL_SIZE; i++) change(1);
+  change(0);
+  for (step = 1; step <= JOURNAL_STATE_BYTES; step++)
+  {
+    writes = host_eeprom_writes;
+    CHECK(command(0, !position[0]), "device 1: no coil switched on");
+    for (i = 0; (i < 1000) && (host_eeprom_writes - writes < step); i++) host_run_us(1000);
+    CHECK(host_eeprom_writes - writes == step, "%lu bytes written instead of %u", host_eeprom_writes - writes, step);
+    power_up();
+    check_restored("power loss during a write");
+  }
+
+  // The next change is written completely
+  change(0);
+  power_up();
+  check_restored("after power loss and a new change");
+
+  return host_test_result("test_journal");
+}
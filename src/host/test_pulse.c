@@ -0,0 +1,116 @@
+//*****************************************************************************************************
+//
+// file:      host/test_pulse.c
+// purpose:   Host test of the coil pulse length (CV3..6, CV51) and the coil queue (CV50)
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// A coil is switched on by set_switch(), and the time till it is switched off is measured on the
+// output port. It is checked that:
+// - with the pulse engine (CV51 > 0) the pulse is CV3 * CV51 ms, with a resolution of 1ms
+// - with 20ms ticks (CV51 = 0) the pulse is between (CV3 - 1) and CV3 ticks
+// - with CV50 = 1 a queued coil is switched on within 1ms after the previous coil is switched off
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "rs_bus_hardware.h"
+#include "cv_pom.h"
+#include "host_test.h"
+
+static void start(unsigned char unit, unsigned char hold_time, unsigned char max_coils)
+{
+  host_reset();
+  CV.myAddrL = 1;
+  CV.T_on_F1 = hold_time;
+  CV.T_on_F2 = hold_time;
+  CV.PulseUnit = unit;
+  CV.MaxCoils = max_coils;
+  CV.HoldDuty = 0;
+  CV.AlwaysAct = 1;				// each command fires its coil (relays4 default: 0)
+  init_hardware();
+  init_global();
+  init_cv_shadow();
+  init_timer1();
+  init_RS_hardware();				// Timer2: the 1ms pulse engine
+  init_switches();
+  sei();
+  host_run_us(100000);				// the restart is over
+}
+
+static void command(unsigned char device, unsigned char gate)
+{
+  TargetDevice = device;
+  TargetGate = gate;
+  TargetActivate = 1;
+  set_switch();
+}
+
+// Time (ms) that the output bits in mask stay on (0: never switched on)
+static double pulse(unsigned char mask)
+{
+  uint64_t t0;
+  unsigned long t;
+  if ((PORTC & mask) == 0) return(0);
+  t0 = host_cycles;
+  for (t = 0; (t < 2000000) && (PORTC & mask); t += 50) host_run_us(50);
+  return((host_cycles - t0) * 1000.0 / F_CPU);
+}
+
+int main(void)
+{
+  unsigned char coil_1, coil_2;
+  double ms;
+  uint64_t t_off;
+
+  // Pulse engine, 1ms unit
+  start(1, 37, 0);
+  command(0, 1);
+  ms = pulse(0xFF);
+  printf("test_pulse: CV51=1 CV3=37: pulse of %.2f ms\n", ms);
+  CHECK((ms >= 36) && (ms <= 38), "CV51=1 CV3=37: pulse of %.2f ms", ms);
+
+  // Pulse engine, 20ms unit
+  start(20, 5, 0);
+  command(0, 0);
+  ms = pulse(0xFF);
+  printf("test_pulse: CV51=20 CV3=5: pulse of %.2f ms\n", ms);
+  CHECK((ms >= 99) && (ms <= 101), "CV51=20 CV3=5: pulse of %.2f ms", ms);
+
+  // 20ms ticks: the first tick may come at any moment
+  start(0, 5, 0);
+  command(0, 1);
+  ms = pulse(0xFF);
+  printf("test_pulse: CV51=0 CV3=5: pulse of %.2f ms\n", ms);
+  CHECK((ms >= 80) && (ms <= 101), "CV51=0 CV3=5: pulse of %.2f ms", ms);
+
+  // One coil at a time: the second coil waits for the first, and starts within 1ms
+  start(1, 30, 1);
+  command(0, 1);
+  coil_1 = PORTC;
+  command(1, 1);
+  CHECK(PORTC == coil_1, "CV50=1: second coil switched on too early (%02x)", PORTC);
+  ms = pulse(coil_1);
+  CHECK((ms >= 29) && (ms <= 31), "CV50=1: first pulse of %.2f ms", ms);
+  t_off = host_cycles;
+  while (((PORTC & ~coil_1) == 0) && ((host_cycles - t_off) < F_CPU / 100)) host_run_us(50);
+  coil_2 = PORTC & ~coil_1;
+  ms = (host_cycles - t_off) * 1000.0 / F_CPU;
+  printf("test_pulse: CV50=1: queued coil started %.2f ms after the first coil\n", ms);
+  CHECK(coil_2 != 0, "CV50=1: queued coil not started");
+  CHECK(ms <= 1.05, "CV50=1: queued coil started after %.2f ms", ms);
+  CHECK(!(PORTC & coil_1), "CV50=1: first coil on again");
+  ms = pulse(coil_2);
+  CHECK((ms >= 29) && (ms <= 31), "CV50=1: second pulse of %.2f ms", ms);
+
+  return host_test_result("test_pulse");
+}
@@ -0,0 +1,172 @@
+//*****************************************************************************************************
+//
+// file:      host/test_receiver.c
+// purpose:   Host test of the DCC receiver under load: interrupt latency, RS-bus and Timer2 activity
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// The simulated ISRs take no time, so the latency that other ISRs cause on the real decoder is
+// modelled by delaying each DCC edge by a random 0..LATENCY us. Meanwhile the RS-bus master polls
+// (INT0 every 200us), the feedback inputs are sampled each 1ms (CV35 = 8) and change now and then,
+// and coils are pulsed with the 1ms pulse engine (CV51 = 1). Both receiver variants (RECEIVER=
+// sampling / timestamp) must deliver every packet, with the nominal signal (58us / 100us halves)
+// and with a signal at the NMRA limits (64us / 90us halves).
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "dcc_receiver.h"
+#include "dcc_decode.h"
+#include "rs_bus_hardware.h"
+#include "cv_pom.h"
+#include "host_test.h"
+
+#define PACKETS 400
+
+// The packets that are sent in turn (the last byte is the XOR byte)
+static const unsigned char packets[][4] = {
+  {3, 0x81, 0xF8, 0x79},                      // accessory, address 1 (our address), gate 0 on
+  {3, 0x81, 0xF9, 0x78},                      // accessory, address 1, gate 1 on
+  {3, 0x85, 0xF8, 0x7D},                      // accessory, other decoder
+  {3, 0x03, 0x3F, 0x3C},                      // loco 3, speed step
+  {3, 0xFF, 0x00, 0xFF},                      // idle
+};
+#define NR_PACKETS (sizeof(packets) / sizeof(packets[0]))
+
+// Edges of the DCC signal, each delayed by the interrupt latency
+static unsigned char bits[80];
+static unsigned char nr_bits, bit, half;
+static double dcc_next;                       // time (us) of the next edge, without latency
+static double dcc_latency;                    // latency of that edge
+
+// RS-bus polling
+static unsigned char rs_pulse, rs_level;
+static double rs_next;
+
+static unsigned int sent, received, wrong;
+static unsigned char next_expected;
+
+static void next_packet(unsigned char p)
+{
+  unsigned char i, j;
+  nr_bits = 0;
+  for (i = 0; i < 14; i++) bits[nr_bits++] = 1;                   // preamble
+  for (i = 1; i <= packets[p][0]; i++)
+  {
+    bits[nr_bits++] = 0;                                          // start bit
+    for (j = 0; j < 8; j++) bits[nr_bits++] = (packets[p][i] >> (7 - j)) & 1;
+  }
+  bits[nr_bits++] = 1;                                            // end bit
+  bit = 0;
+  half = 0;
+}
+
+static void check_messages(void)
+{
+  while (dcc_message_available())
+  {
+    t_message *m = dcc_message_peek();
+    const unsigned char *p = packets[next_expected];
+    if ((m->size == p[0]) && (memcmp(m->dcc, &p[1], p[0]) == 0))
+    {
+      received++;
+      next_expected = (next_expected + 1) % NR_PACKETS;
+    }
+    else wrong++;
+    analyze_message(m);
+    dcc_message_release();
+    if (CmdType == ACCESSORY_CMD) set_switch();
+  }
+}
+
+static void run(unsigned int half_1, unsigned int half_0, unsigned int latency)
+{
+  double now = 0;
+  unsigned long changes = 0;
+  host_reset();
+  CV.myAddrL = 1;
+  CV.MyRsAddr = 5;
+  CV.SendFB = 1;
+  CV.FBDebounce = 8;
+  CV.PulseUnit = 1;
+  CV.AlwaysAct = 1;
+  init_hardware();
+  init_global();
+  init_cv_shadow();
+  init_dcc_receiver();
+  init_dcc_decode();
+  init_timer1();
+  init_RS_hardware();
+  init_switches();
+  init_switch_feedback();
+  sei();
+
+  srand(latency * 1000 + half_1);
+  sent = received = wrong = 0;
+  next_expected = 0;
+  next_packet(0);
+  host_set_input(&PIND, 3, 1);
+  dcc_next = 1000;
+  dcc_latency = 0;
+  rs_pulse = 0;
+  rs_level = 1;
+  rs_next = 1000;
+  host_set_input(&PIND, 2, 1);
+  while (sent < PACKETS)
+  {
+    double t_dcc = dcc_next + dcc_latency;
+    double t = (t_dcc < rs_next) ? t_dcc : rs_next;
+    host_advance_cycles((uint64_t)((t - now) * (F_CPU / 1000000.0)));
+    now = t;
+    if (t == t_dcc)
+    {
+      host_set_input(&PIND, 3, half == 0 ? 1 : 0);
+      dcc_next += bits[bit] ? half_1 : half_0;
+      dcc_latency = (rand() % (latency * 10 + 1)) / 10.0;
+      if (half) {bit++; half = 0;} else half = 1;
+      if (bit >= nr_bits) {sent++; next_packet(sent % NR_PACKETS);}
+    }
+    else
+    {
+      // the decoder sends on the falling edge
+      rs_level = !rs_level;
+      host_set_input(&PIND, 2, rs_level);
+      if (!rs_level) rs_next += 100;
+        else if (++rs_pulse < 130) rs_next += 100;
+        else {rs_pulse = 0; rs_next += 7000;}
+    }
+    // main: DCC messages (checked here, then decoded and executed), timers, feedback and pulses
+    check_messages();
+    host_main_loop();
+    if ((rand() % 2000) == 0) {PINA ^= (1 << (rand() % 8)); changes++;}
+  }
+  // the rising edge that ends the last bit (the timestamp receiver needs it)
+  host_advance_cycles((uint64_t)((dcc_next - now) * (F_CPU / 1000000.0)));
+  host_set_input(&PIND, 3, 1);
+  host_advance_us(1000);
+  check_messages();
+  printf("test_receiver: halves %u/%uus, latency 0..%uus: %u of %u packets (%lu feedback changes)\n",
+         half_1, half_0, latency, received, sent, changes);
+  CHECK(wrong == 0, "halves %u/%uus, latency %u: %u wrong messages", half_1, half_0, latency, wrong);
+  CHECK(received == sent, "halves %u/%uus, latency %u: %u of %u packets", half_1, half_0, latency,
+        received, sent);
+}
+
+int main(void)
+{
+  run(58, 100, 0);
+  run(58, 100, 15);
+  run(64, 90, 10);
+  return host_test_result("test_receiver");
+}
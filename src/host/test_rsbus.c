@@ -0,0 +1,227 @@
+//*****************************************************************************************************
+//
+// file:      host/test_rsbus.c
+// purpose:   Host test of the RS-bus feedback: transmit queue, registration and feedback latency
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2026-10-17 V0.1 Initial version
+//
+//*****************************************************************************************************
+//
+// With simulated RS-bus polling cycles (130 addresses, see hal_host.c) it is checked that:
+// - at most one byte is send per polled address and cycle, and only on our address(es)
+// - registration (RS_connect) sends one nibble per polling cycle; the decoder only reports
+//   connected once the last nibble is queued
+// - a changed feedback signal is reported after 8 equal samples: within about 200ms if sampled
+//   each 20ms tick (CV35 = 0), and in the next polling cycle if sampled each 1ms (CV35 = 8)
+// - each changed nibble is send 1 + CV20 times
+// - with fast sampling, main is not woken up (EV_FEEDBACK) if nothing changed, nor if nothing can
+//   be send: without RS-bus master, or without RS-bus address (CV10 = 0)
+//
+//*****************************************************************************************************
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "hardware.h"
+#include "rs_bus_hardware.h"
+#include "rs_bus_messages.h"
+#include "cv_pom.h"
+#include "host_test.h"
+
+#define MY_RS_ADDR 5
+
+// Bytes in the log of the last polling cycle(s), and checks on the addresses they were send on
+static unsigned char check_log(unsigned char skip)
+{
+  unsigned char i, j;
+  for (i = 0; i < host_rsbus_count; i++)
+  {
+    CHECK((host_rsbus_log[i].address == MY_RS_ADDR) || (skip && (host_rsbus_log[i].address == MY_RS_ADDR + 1)),
+          "byte %02x send on address %u", host_rsbus_log[i].data, host_rsbus_log[i].address);
+    for (j = 0; j < i; j++)
+      CHECK(host_rsbus_log[j].address != host_rsbus_log[i].address, "two bytes on address %u in one cycle",
+            host_rsbus_log[i].address);
+  }
+  return(host_rsbus_count);
+}
+
+static void start(unsigned char skip, unsigned char debounce, unsigned char retry)
+{
+  host_reset();
+  CV.myAddrL = 1;
+  CV.MyRsAddr = MY_RS_ADDR;
+  CV.SendFB = 1;
+  CV.SkipUnEven = skip;
+  CV.FBDebounce = debounce;
+  CV.RSRetry = retry;
+  init_hardware();
+  init_global();
+  init_cv_shadow();
+  init_timer1();
+  init_RS_hardware();
+  init_switches();
+  init_switch_feedback();
+  sei();
+}
+
+// Run polling cycles till the decoder is connected; returns the number of cycles
+static unsigned char connect(unsigned char skip)
+{
+  unsigned char cycle, send = 0, nibbles = skip ? 4 : 2;
+  for (cycle = 1; cycle <= 20; cycle++)
+  {
+    host_rsbus_count = 0;
+    host_run_rsbus_cycle();
+    send += check_log(skip);
+    CHECK(host_rsbus_count <= 1, "registration: %u nibbles in cycle %u", host_rsbus_count, cycle);
+    if (send >= nibbles) break;
+    // the last nibble is queued in the cycle before it is send
+    CHECK(!RS_Layer_2_connected || (send == nibbles - 1), "connected after %u of %u nibbles", send, nibbles);
+  }
+  CHECK(send == nibbles, "registration: %u nibbles send, expected %u", send, nibbles);
+  CHECK(RS_Layer_2_connected, "not connected after registration");
+  return(cycle);
+}
+
+// Run polling cycles till a cycle without bytes: the retransmissions (CV20) of the registration
+// nibbles are over
+static void drain(void)
+{
+  unsigned char cycle;
+  for (cycle = 0; cycle < 10; cycle++)
+  {
+    host_rsbus_count = 0;
+    host_run_rsbus_cycle();
+    if (check_log(0) == 0) return;
+  }
+  CHECK(0, "still sending after 10 polling cycles");
+}
+
+// Change feedback signal 0, and return the time (ms) till the first byte is send (0: none)
+static double latency(void)
+{
+  unsigned char cycle;
+  uint64_t t0 = host_cycles;
+  PINA ^= 0x01;
+  for (cycle = 0; cycle < 20; cycle++)
+  {
+    unsigned char address;
+    // host_run_rsbus_cycle(), but noting the time of the first byte
+    for (address = 0; address < 130; address++)
+    {
+      UDR = 0;
+      host_set_input(&PIND, 2, 1);
+      host_run_us(100);
+      host_set_input(&PIND, 2, 0);
+      if (UDR != 0)
+      {
+        CHECK(address == MY_RS_ADDR, "feedback send on address %u", address);
+        CHECK(((UDR >> DATA_1) & 1) == (PINA & 0x01), "feedback byte %02x does not show signal 0", UDR);
+        return((host_cycles - t0) * 1000.0 / F_CPU);
+      }
+      host_run_us(100);
+    }
+    host_set_input(&PIND, 2, 1);
+    host_run_us(7000);
+  }
+  return(0);
+}
+
+// Number of times main is woken up (EV_FEEDBACK) during a number of polling cycles (polled = 1),
+// or during the same time without RS-bus signal (polled = 0)
+static unsigned int wakeups(unsigned char cycles, unsigned char polled)
+{
+  unsigned int count = 0;
+  unsigned char cycle, address;
+  for (cycle = 0; cycle < cycles; cycle++)
+  {
+    for (address = 0; address < 131; address++)
+    {
+      events &= ~(1<<EV_FEEDBACK);
+      if (address < 130)
+      {
+        if (polled) host_set_input(&PIND, 2, 1);
+        host_advance_us(100);
+        if (polled) host_set_input(&PIND, 2, 0);
+        host_advance_us(100);
+      }
+      else
+      {
+        if (polled) host_set_input(&PIND, 2, 1);
+        host_advance_us(7000);
+      }
+      if (events & (1<<EV_FEEDBACK)) count++;
+      host_main_loop();
+    }
+  }
+  return(count);
+}
+
+int main(void)
+{
+  unsigned char skip, cycles, cycle, total;
+  double ms;
+
+  // Registration, with one and with two RS-bus addresses
+  for (skip = 0; skip <= 1; skip++)
+  {
+    start(skip, 8, 0);
+    cycles = connect(skip);
+    printf("test_rsbus: CV21=%u registered in %u polling cycles\n", skip, cycles);
+  }
+
+  // Feedback latency with slow (20ms tick) and fast (1ms) sampling
+  start(0, 0, 0);
+  connect(0);
+  ms = latency();
+  printf("test_rsbus: CV35=0: feedback after %.1f ms\n", ms);
+  CHECK((ms >= 160) && (ms <= 230), "CV35=0: feedback after %.1f ms", ms);
+  start(0, 8, 0);
+  connect(0);
+  ms = latency();
+  printf("test_rsbus: CV35=8: feedback after %.1f ms\n", ms);
+  CHECK((ms >= 8) && (ms <= 45), "CV35=8: feedback after %.1f ms", ms);
+
+  // Retransmissions: with CV20 = 2 a changed nibble is send three times, in three cycles
+  start(0, 8, 2);
+  connect(0);
+  drain();
+  PINA ^= 0x04;
+  total = 0;
+  for (cycle = 0; cycle < 6; cycle++)
+  {
+    host_rsbus_count = 0;
+    host_run_rsbus_cycle();
+    total += check_log(0);
+  }
+  CHECK(total == 3, "CV20=2: changed nibble send %u times, expected 3", total);
+
+  // Nothing changed: no work for main, and nothing is send
+  events = 0;
+  for (cycle = 0; cycle < 3; cycle++)
+  {
+    host_rsbus_count = 0;
+    host_run_rsbus_cycle();
+    CHECK(host_rsbus_count == 0, "%u bytes send without a change", host_rsbus_count);
+  }
+  host_advance_us(5000);
+  CHECK(!(events & (1<<EV_FEEDBACK)), "EV_FEEDBACK raised without a change");
+
+  // No RS-bus master, or no RS-bus address: nothing can be send, so main is not woken up
+  start(0, 8, 0);
+  PINA ^= 0x01;
+  total = wakeups(5, 0);
+  CHECK(total == 0, "no RS-bus master: main woken up %u times", total);
+  start(0, 8, 0);
+  My_RS_Addr = 0;
+  PINA ^= 0x01;
+  total = wakeups(5, 1);
+  CHECK(RS_Layer_1_active, "RS-bus not active");
+  CHECK(total == 0, "CV10=0: main woken up %u times", total);
+
+  return host_test_result("test_rsbus");
+}
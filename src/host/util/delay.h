@@ -0,0 +1,17 @@
+//*****************************************************************************************************
+//
+// file:      host/util/delay.h
+// purpose:   Host (x86) replacement for <util/delay.h>
+//            Busy waiting is not simulated: the delay loops return immediately.
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+#define _UTIL_DELAY_H_
+#include <stdint.h>
+
+static inline void _delay_loop_2(uint16_t __count) { (void)__count; }
+static inline void _delay_us(double __us) { (void)__us; }
+static inline void _delay_ms(double __ms) { (void)__ms; }
@@ -0,0 +1,12 @@
+//*****************************************************************************************************
+//
+// file:      host/util/parity.h
+// purpose:   Host (x86) replacement for <util/parity.h>
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+//
+//*****************************************************************************************************
+#pragma once
+
+#define parity_even_bit(val)    ((unsigned char)__builtin_parity((unsigned char)(val)))
@@ -15,6 +15,11 @@
 // history:   2011-12-31 V0.01 ap first version, supporting RS-Bus feedback of switch values
 //            2014-01-06 V0.02 ap second version, supporting PoM of CV values
 //				  Second version uses identical software for switch and relays decoders
+//            2026-10-16 V0.03    Feedbacks are handled after each new sample (each 1ms if CV35 > 0)
+//                                Queued coils are started as soon as a 1ms-timed pulse ends
+//                                Accessory commands for other decoders may trigger a route
+//                                Event driven main loop; the CPU sleeps (idle) if there is nothing to do
+//                                Timeouts are handled by software timers (run_timers), not each tick
 //
 //*****************************************************************************************************
 //
@@ -41,6 +46,7 @@
 #include <avr/io.h>
 #include <avr/eeprom.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>             // idle sleep if there is nothing to do
 #include <string.h>
 
 #include "global.h"              // global variables
@@ -131,8 +137,9 @@ void DoProgramming(void) {
     if (Ticks_Waited <= 50) {                   // button is released within 5 sec => programme address
       WaitDebounceTime();                       // Busy wait debouncing time, for stable button release
       while(!PROG_PRESSED) {
-        if (semaphor_get(C_Received)) {         // Message
-          analyze_message(&incoming);
+        if (dcc_message_available()) {          // Message
+          analyze_message(dcc_message_peek());
+          dcc_message_release();
           // CmdType == ANY_ACCESSORY_CMD => Accessory command but not for my current address 
           // CmdType == ACCESSORY_CMD     => Accessory command for my current address 
           if ((CmdType == ACCESSORY_CMD) || (CmdType == ANY_ACCESSORY_CMD)){
@@ -226,8 +233,11 @@ void init_global(void)
 //*****************************************************************************************************
 int main(void)
   {
+    unsigned char ev;			// events taken from the ISRs
+
     init_hardware();			// setup hardware ports
     init_global();			    // initialise the global variables
+    init_cv_shadow();			// RAM copy of the CVs needed for each DCC packet
     
     init_dcc_receiver();		// setup dcc receiver
     init_dcc_decode();
@@ -254,26 +264,42 @@ int main(void)
     // check if the decoder has a valid Decoder address
     if (My_Dec_Addr == INVALID_DEC_ADR) flash_led_fast(5);
     
+    set_sleep_mode(SLEEP_MODE_IDLE);	// timers, INT0, INT1 and the UART keep running
     while(1) {
-      if (PROG_PRESSED) DoProgramming();
-      if (semaphor_query(C_Received)) {	// DCC message received
-        analyze_message(&incoming);
+      // Take the events set by the ISRs. If there are none, sleep till the next interrupt.
+      // Interrupts remain disabled till the sleep instruction (sei delays them by one
+      // instruction), so an event that is set in between wakes us up again
+      cli();
+      ev = events;
+      events = 0;
+      if (ev == 0) {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        continue;
+      }
+      sei();
+      if (ev & (1<<EV_BUTTON)) {
+        DoProgramming();
+        cli();
+        events &= ~(1<<EV_BUTTON);	// set again by the timer ISR while DoProgramming waited
+        sei();
+      }
+      if (ev & (1<<EV_DCC)) while (dcc_message_available()) {	// DCC message(s) received
+        analyze_message(dcc_message_peek());
+        dcc_message_release();		// results are in global variables, so free the slot
         if (CmdType >= 1) {   
-          if (CmdType == ANY_ACCESSORY_CMD) {};
+          if (CmdType == ANY_ACCESSORY_CMD) set_route();
           if (CmdType == ACCESSORY_CMD)	set_switch();
           if (CmdType == LOCO_F0F4_CMD)	set_switch();
           if (CmdType == POM_CMD)	cv_operation(POM_CMD); 
           if (CmdType == SM_CMD) 	cv_operation(SM_CMD); 
         }
-        semaphor_get(C_Received);	// now take away the protection
-      }
-      if (timer1fired) {		// 1 time tick (20ms) has passed)
-        check_led_time_out();
-        check_switch_time_out();
-        check_PoM_time_out();
-        if (Have_Feedback) {send_switch_feedback();}
-        timer1fired = 0;
       }
+      if (ev & (1<<EV_TIMER)) run_timers();	// LED, switches, PoM, slow feedback sampling, ...
+      if (Have_Feedback && (ev & (1<<EV_FEEDBACK))) send_switch_feedback();	// changed or pending feedback
+      if (ev & (1<<EV_PULSE)) start_queued_coils();	// a pulse timed by the 1 ms Timer2 ISR is over
     } // End WHILE
     
   }
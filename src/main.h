@@ -1,23 +1,23 @@
-//------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder2
-//
-// Copyright (c) 2006 Kufer
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-// 
-//------------------------------------------------------------------------
-//
-// file:      main.h
-// author:    Wolfgang Kufer
-// contact:   kufer@gmx.de
-// webpage:   http://www.opendcc.de
-// history:   2006-02-14 V0.1 kw start
-//
-//------------------------------------------------------------------------
-//
-// purpose:   flexible general purpose decoder for dcc
-//
-//------------------------------------------------------------------------
+//------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder2
+//
+// Copyright (c) 2006 Kufer
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+// 
+//------------------------------------------------------------------------
+//
+// file:      main.h
+// author:    Wolfgang Kufer
+// contact:   kufer@gmx.de
+// webpage:   http://www.opendcc.de
+// history:   2006-02-14 V0.1 kw start
+//
+//------------------------------------------------------------------------
+//
+// purpose:   flexible general purpose decoder for dcc
+//
+//------------------------------------------------------------------------
@@ -1,49 +1,80 @@
-//************************************************************************************************
-//
-// file:      rs_bus_hardware.h
-//
-// purpose:   Physical layer routines for the RS feedback bus
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-//
-// history:  2010-11-10 ap V0.1 Initial version
-// 	     2010-11-10 ap V0.2 RS-bus defines have been moved to here (made global)
-//
-//************************************************************************************************
-#pragma once
-
-// The following #define may be changed: the kind of RS-bus module
-#define RS_BUS_TYPE     0       // 0: switch decoder with feedback / 1: feedback decoder
-
-
-//************************************************************************************************
-// DO NOT MODIFY BELOW THIS LINE
-// Define the bits of the RS-bus "packet" (1 byte)
-// Note: least significant bit (LSB) first. Thus the parity bit comes first,
-// immediately after the USART's start bit. Because of this (unusual) order, the USART hardware
-// can not calculate the parity bit itself; such calculation must be done in software.
-#define DATA_0          7       // feedback 1 or 5
-#define DATA_1          6       // feedback 2 or 6
-#define DATA_2          5       // feedback 3 or 7
-#define DATA_3          4       // feedback 4 or 8
-#define NIBBLE          3       // low or high order nibble
-#define TT_BIT_0        2       // this bit must always be 0
-#define TT_BIT_1        1       // this bit must always be 1
-#define PARITY          0       // parity bit; will be calculated by software
-
-
-//************************************************************************************************
-// Global Data: 
-volatile unsigned char RS_Layer_1_active;    // Flag to signal valid RS-bus signal 
-volatile unsigned char RS_Layer_2_connected; // Flag to signal slave must connect to the master
-volatile unsigned char RS_data2send_flag;    // Flag that this feedback module wants to send data
-volatile unsigned char RS_data2send;         // Actual data byte that will be send over the RS-bus
-
-volatile unsigned char T_Sample;             // Used by adc_hardware as interval between AD conversions
-volatile unsigned char T_DelayOff;           // Used by adc_hardware as to time delay before OFF message
-
-//************************************************************************************************
-// Hardware initialisation and ISR routines
-void init_RS_hardware(void);
+//************************************************************************************************
+//
+// file:      rs_bus_hardware.h
+//
+// purpose:   Physical layer routines for the RS feedback bus
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+//
+// history:  2010-11-10 ap V0.1 Initial version
+// 	     2010-11-10 ap V0.2 RS-bus defines have been moved to here (made global)
+//           2026-10-16    V0.3 Transmit queue replaces RS_data2send / RS_data2send_flag
+//                              The queue is declared extern here, and defined in rs_bus_hardware.c
+//
+//************************************************************************************************
+#pragma once
+
+// The following #define may be changed: the kind of RS-bus module
+#define RS_BUS_TYPE     0       // 0: switch decoder with feedback / 1: feedback decoder
+
+
+//************************************************************************************************
+// DO NOT MODIFY BELOW THIS LINE
+// Define the bits of the RS-bus "packet" (1 byte)
+// Note: least significant bit (LSB) first. Thus the parity bit comes first,
+// immediately after the USART's start bit. Because of this (unusual) order, the USART hardware
+// can not calculate the parity bit itself; such calculation must be done in software.
+#define DATA_0          7       // feedback 1 or 5
+#define DATA_1          6       // feedback 2 or 6
+#define DATA_2          5       // feedback 3 or 7
+#define DATA_3          4       // feedback 4 or 8
+#define NIBBLE          3       // low or high order nibble
+#define TT_BIT_0        2       // this bit must always be 0
+#define TT_BIT_1        1       // this bit must always be 1
+#define PARITY          0       // parity bit; will be calculated by software
+
+
+//************************************************************************************************
+// Global Data: 
+volatile unsigned char RS_Layer_1_active;    // Flag to signal valid RS-bus signal 
+volatile unsigned char RS_Layer_2_connected; // Flag to signal slave must connect to the master
+
+// Transmit queue. Each entry holds a formatted RS-bus byte plus the address it must be send on.
+// Entries are added by RS_queue_put() (main program) and removed by the INT0 ISR, once the 
+// master polls the address of the oldest entry. At most one byte is send per polled address.
+#define RS_QUEUE_SIZE   8       // must be a power of 2
+typedef struct
+  {
+    unsigned char address;      // RS-bus address (1..128) 
+    unsigned char data;         // formatted byte (parity, TT-bits, nibble and four data bits)
+  } t_rs_entry;
+
+extern t_rs_entry RS_queue[RS_QUEUE_SIZE];          // defined in rs_bus_hardware.c
+extern volatile unsigned char RS_queue_head;        // next free entry; only changed by RS_queue_put()
+extern volatile unsigned char RS_queue_tail;        // oldest entry; only changed by the ISRs
+
+volatile unsigned char T_Sample;             // Used by adc_hardware as interval between AD conversions
+volatile unsigned char T_DelayOff;           // Used by adc_hardware as to time delay before OFF message
+
+//************************************************************************************************
+// Hardware initialisation and ISR routines
+void init_RS_hardware(void);
+
+// Add a byte to the transmit queue. Never blocks: returns 0 (and drops the byte) if the queue is full
+unsigned char RS_queue_put(unsigned char address, unsigned char data);
+
+// Number of entries that can still be added to the transmit queue
+static inline unsigned char RS_queue_free(void) __attribute__((always_inline));
+unsigned char RS_queue_free(void)
+{
+  return((RS_queue_tail - RS_queue_head - 1) & (RS_QUEUE_SIZE - 1));
+}
+
+// True if all queued bytes have been send
+static inline unsigned char RS_queue_empty(void) __attribute__((always_inline));
+unsigned char RS_queue_empty(void)
+{
+  return(RS_queue_head == RS_queue_tail);
+}
@@ -1,196 +1,711 @@
-//*****************************************************************************************************
-//
-// OpenDCC - OpenDecoder2.2
-//
-// Copyright (c) 2011,2013 Pras
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
-// 
-//*****************************************************************************************************
-//
-// file:      switch.c
-// author:    Aiko Pras
-// history:   2012-01-08 V0.1 ap based upon port_engine.c from the OpenDecoder2 project => relays.c
-//            2013-12-25 V0.2 ap based upon relays.c => switch.c
-//				 changed all relay specific code in switch specific code
-//            2015-01-06 V0.3 ap Changed switch numbering such that it is now left to right
-//
-//
-// A DCC Switch Decoder for ATmega16A and other AVR.
-//
-// Uses the following global variables:
-// - TargetDevice: the switch / relays4 that is being addressed. Range: 0 .. (NUMBER_OF_DEVICES - 1)
-//   For normal switch / relays4 decoders, the range will be 0..3
-// - TargetGate: Targetted coil within that Port. Usually - or + / green or red
-// - TargetActivate: Coil activation (value = 1) or deactivation (value = 0) 
-//
-//*****************************************************************************************************
-
-#include <stdlib.h>
-#include <stdbool.h>
-#include <inttypes.h>
-#include <avr/pgmspace.h>
-#include <avr/io.h>
-#include <avr/eeprom.h>
-#include <avr/interrupt.h>
-
-#include "global.h"
-#include "config.h"
-#include "myeeprom.h"
-#include "hardware.h"
-#include "timer1.h"
-#include "switch.h"
-#include "led.h"
-
-//*****************************************************************************************************
-//************************************ Definitions and declarations ***********************************
-//*****************************************************************************************************
-#define GREEN 	          0         // The green coil 
-#define RED 	          1         // The red coil 
-#define UNKNOWN           2         // If we start up and do not know the position before power-down
-
-
-typedef struct {
-  unsigned char gate_pos;	    // which of the two gates is currently on (RED or GREEN)
-  unsigned char hold_time;	    // maximum pulse duration to activate the gate (in 20 ms ticks)
-  unsigned char rest_time;	    // remaining puls duration during gate activation
-} t_device;
-
-t_device devices[4];		    // we have 4 devices (switches, relays, ...) with each two coils  
-
-unsigned char always_activate_coil; // Coil will be activated even if it is already in the right position
-
-//*****************************************************************************************************
-//********************************** Local functions (called locally) *********************************
-//*****************************************************************************************************
-void init_switch(unsigned char device) {
-  // device range: 0..3
-  // initialise the "administration" for the requested switch
-  // Although we could measure the gate position, not doing so has as only "disadvantage" that the
-  // first time the gate (switch) is activated, it may allready have been in the requested position. 
-  devices[device].gate_pos = UNKNOWN;
-  // store the maximum puls time
-  devices[device].hold_time = my_eeprom_read_byte(&CV.T_on_F1 + device);
-  // in case of relays, initialise the gate to a default position by setting the remaining puls time
-  if (MyType == TYPE_RELAYS4) {
-    devices[device].rest_time = 0;
-  }
-}
-
-// The routine below is (currently) not being used. It would set switches / relays to a predefined
-// (=GREEN) position, and block for roughly 50 ms, to avoid that multiple switches will change together.
-void init_relays_and_block(unsigned char device) {
-  // Similar to above, but this time set the relay to a defined position and subsequently 
-  // block for roughly 50 ms
-  // device range: 0..3
-  // initialise the "administration" for the requested relay
-  devices[device].gate_pos = GREEN;
-  // store the maximum puls time
-  devices[device].hold_time = my_eeprom_read_byte(&CV.T_on_F1 + device);
-  // initialise the gate to a default position by setting the remaining puls time
-  // never do this for switches, however...
-  devices[device].rest_time = devices[device].hold_time;
-  // do the actual setting of the coil now! Note we set the first (of both) coils
-  unsigned char coil = device * 2;	
-  OUTPUT_PORT |= (0x80>>coil);	// activate the first gate (coil) of the relays
-  // Wait for roughly 50 seconds now
-  unsigned char number_of_ticks = 0;
-  while (number_of_ticks < 3) {
-    if (timer1fired) { 
-      number_of_ticks ++;
-      check_led_time_out();
-      check_switch_time_out();
-    }
-    timer1fired = 0;
-  }
-}
-
-//*****************************************************************************************************
-//********************************* Main functions (called externally) ********************************
-//*****************************************************************************************************
-void init_switches(void) {
-  // first disable all outputs
-  OUTPUT_PORT = 0x00;
-  // initialise for all switches the "administration"
-  // continue from the last switches positions before power-down.
-  init_switch(0);
-  init_switch(1);
-  init_switch(2);
-  init_switch(3);
-  // note that we should call init_relay_and_block() in case we want to set the 
-  // relays to a predefined position and wait 50 ms between setting each relay  
-  // 
-  // Determine of coils should only be activated in case their position has changed, or if they 
-  // should allways be activated after reception of a Accesory Decoder command. In the later case 
-  // the coil will be activated again for each retranmission, or in case of a handheld as long as
-  // the + or - button is pushed.
-  // Note that, in case of AlwaysAct, a Feedback message will be generated even in case the switch 
-  // has not changed. Some programs, such as Railware, expect such behavior.
-  always_activate_coil = my_eeprom_read_byte(&CV.AlwaysAct);
-}
-
-
-void set_switch(void) { 
-  // This function is called from main, after a DCC accessory decoder command  
-  // or a loco F1..F4 command is received
-  // We do timer-based de-activation, so no need to react on de-activation messages 
-  if (TargetActivate) {
-    // Always react, even if the current gate position is the same as the requested position
-    // This ensures that the coil will always be activated, and a feedback message being send
-    // As a consequence, the coil may receive many pulses in a row
-    if ((devices[TargetDevice].gate_pos != TargetGate) || (always_activate_coil != 0)) { 
-      activity_led();
-      // Note: Switch and Relays PCBs connect the output port in different ways
-      if (MyType == TYPE_SWITCH) {
-        // For switch decoders, TargetDevice is in the range 0..3
-        // first deactivate all gates (coils)
-        OUTPUT_PORT &= ~(0x80>>(2*TargetDevice)); 		// clear first gate (coil) of this device
-        OUTPUT_PORT &= ~(0x80>>(2*TargetDevice + 1));		// clear second gate (coil) of this device
-        // select the active gate
-        devices[TargetDevice].gate_pos = TargetGate;
-        // set the activation time
-        devices[TargetDevice].rest_time = devices[TargetDevice].hold_time;
-        // Activate the gate (coil)
-        OUTPUT_PORT |= (0x80>>(2*TargetDevice + TargetGate));	// set the requested port
-      }
-      if (MyType == TYPE_RELAYS4) {
-        // Also for Relays-4 decoders, TargetDevice is in the range 0..3
-        // first deactivate all gates (coils)
-        OUTPUT_PORT &= ~(1<<(2*TargetDevice));			// clear first gate (coil) of this device
-        OUTPUT_PORT &= ~(1<<(2*TargetDevice + 1));		// clear second gate (coil) of this device
-        // select the active gate
-        devices[TargetDevice].gate_pos = TargetGate;
-        // set the activation time
-        devices[TargetDevice].rest_time = devices[TargetDevice].hold_time;
-        // Activate the gate (coil)
-        OUTPUT_PORT |= (1<<(2*TargetDevice + 1 - TargetGate));	// set the requested port
-      }
-    }
-  }
-} 
-
-
-void check_switch_time_out(void) { 
-  // This function is called from main, every time tick (20 ms)  
-  unsigned char i;
-  unsigned char rest_ticks;
-  for (i=0; i<4; i++) {				// check each device (relays, switch, ...)
-    rest_ticks = devices[i].rest_time;		// use a local variable to force compiler to tiny code
-    if (rest_ticks !=0) {			// coil is active / active time is not over yet
-      rest_ticks = rest_ticks - 1;		// decrease remaining time coil should still be active
-      if (rest_ticks == 0) {			// coil should no longer be active?
-        if (MyType == TYPE_SWITCH) {
-          OUTPUT_PORT &= ~(0x80>>(2*i));	// clear first gate (coil) of this device
-          OUTPUT_PORT &= ~(0x80>>(2*i + 1));	// clear second gate (coil) of this device
-        }
-        if (MyType == TYPE_RELAYS4) {
-          OUTPUT_PORT &= ~(1<<(2*i));		// clear first gate (coil) of this device
-          OUTPUT_PORT &= ~(1<<(2*i + 1));	// clear second gate (coil) of this device
-        }
-      }
-      devices[i].rest_time = rest_ticks;
-    }
-  }
-}
-
+//*****************************************************************************************************
+//
+// OpenDCC - OpenDecoder2.2
+//
+// Copyright (c) 2011,2013 Pras
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+// 
+//*****************************************************************************************************
+//
+// file:      switch.c
+// author:    Aiko Pras
+// history:   2012-01-08 V0.1 ap based upon port_engine.c from the OpenDecoder2 project => relays.c
+//            2013-12-25 V0.2 ap based upon relays.c => switch.c
+//				 changed all relay specific code in switch specific code
+//            2015-01-06 V0.3 ap Changed switch numbering such that it is now left to right
+//            2026-10-16 V0.4    AlwaysAct is read from the RAM copy of the CVs (cv_shadow)
+//                               Retransmissions of the same command are ignored (REPEAT_WINDOW)
+//                               Throw time measurement, with an RS-bus alarm for slow / stuck switches
+//                               Coil activations are scheduled; CV50 limits the number of active coils.
+//                               init_relays_and_block() removed (busy waiting); see init_relays_to_green()
+//                               Relays with hold time 0 are set to GREEN at start-up (init_relays_to_green)
+//                               Coil pulses can be ended by the 1 ms Timer2 ISR (CV51)
+//                               PWM hold mode after a pull-in pulse (CV52, CV53)
+//                               Positions are kept in an EEPROM journal, and restored after power-up
+//                               Routes: one accessory command sets up to four devices (CV54-CV77)
+//                               Up to 8 devices (NUMBER_OF_DEVICES), devices 5..8 on EXTENSION_PORT
+//                               The PCB wiring is selected at compile time (DECODER_TYPE), not via MyType
+//                               Coil masks from a PROGMEM table; both gates are updated in one write
+//                               The end of a pulse is signalled to main with EV_PULSE (pulse_ended removed)
+//                               The tick work runs from a software timer, only while there is work to do
+//
+//
+// A DCC Switch Decoder for ATmega16A and other AVR.
+//
+// Uses the following global variables:
+// - TargetDevice: the switch / relays4 that is being addressed. Range: 0 .. (NUMBER_OF_DEVICES - 1)
+//   For normal switch / relays4 decoders, the range will be 0..3
+// - TargetGate: Targetted coil within that Port. Usually - or + / green or red
+// - TargetActivate: Coil activation (value = 1) or deactivation (value = 0) 
+//
+//*****************************************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+
+#include "global.h"
+#include "config.h"
+#include "myeeprom.h"
+#include "hardware.h"
+#include "timer1.h"
+#include "switch.h"
+#include "led.h"
+#include "cv_pom.h"
+#include "switch_feedback.h"
+#include "rs_bus_hardware.h"
+#include "rs_bus_messages.h"
+#include "dcc_receiver.h"
+#include "dcc_decode.h"
+
+//*****************************************************************************************************
+//************************************ Definitions and declarations ***********************************
+//*****************************************************************************************************
+#define GREEN 	          0         // The green coil 
+#define RED 	          1         // The red coil 
+#define UNKNOWN           2         // If we start up and do not know the position before power-down
+
+// Command stations repeat each accessory command several times (the LZV100 sends it four times).
+// A command for the same device and gate within REPEAT_WINDOW ticks after the command that was
+// executed is considered a retransmission, and ignored. 
+#define REPEAT_WINDOW     10        // in 20 ms ticks
+
+#define NO_GATE           0xFF      // No activation of this device is waiting
+
+#if (NUMBER_OF_DEVICES > 8)
+  #error NUMBER_OF_DEVICES: at most 8 devices (4 on OUTPUT_PORT and 4 on EXTENSION_PORT)
+#endif
+
+// Coils are handled as bit masks (t_coils): the low byte holds the bits of OUTPUT_PORT (devices 
+// 1..4), the high byte those of EXTENSION_PORT (devices 5..8, on the extension board). Devices 5..8
+// use the same wiring on EXTENSION_PORT as devices 1..4 on OUTPUT_PORT. 
+// Switch and Relays PCBs connect the output port in different ways. The firmware is built for one
+// of them (DECODER_TYPE, see global.h and the Makefile targets switch, relays4 and relays16):
+// - Switch PCB: device 1 uses bits 7 (green) and 6 (red), ..., device 4 bits 1 and 0
+// - Relays PCB: device 1 uses bits 1 (green) and 0 (red), ..., device 4 bits 7 and 6
+#if (DECODER_TYPE == TYPE_SWITCH)
+  #define GATE_COIL(dev, gate)    (0x80 >> (2*(dev) + (gate)))
+#elif (DECODER_TYPE == TYPE_RELAYS4) || (DECODER_TYPE == TYPE_RELAYS16)
+  #define RELAYS_PCB
+  #define GATE_COIL(dev, gate)    (0x01 << (2*(dev) + 1 - (gate)))
+#else
+  #error DECODER_TYPE: switch.c supports TYPE_SWITCH, TYPE_RELAYS4 and TYPE_RELAYS16
+#endif
+
+#if (NUMBER_OF_DEVICES > 4)
+typedef unsigned int t_coils;
+#else
+typedef unsigned char t_coils;
+#endif
+
+// The coil of each device and gate, computed by the compiler from GATE_COIL. The AVR has no barrel
+// shifter, so a table lookup is much cheaper than shifting by a variable number of bits.
+#define COIL(dev, gate)         ((t_coils) GATE_COIL((dev) & 0x03, gate) << (8 * ((dev) >> 2)))
+
+#if (NUMBER_OF_DEVICES > 4)
+const t_coils coil_table[8][2] PROGMEM = {
+#else
+const t_coils coil_table[4][2] PROGMEM = {
+#endif
+  {COIL(0, GREEN), COIL(0, RED)},
+  {COIL(1, GREEN), COIL(1, RED)},
+  {COIL(2, GREEN), COIL(2, RED)},
+  {COIL(3, GREEN), COIL(3, RED)},
+#if (NUMBER_OF_DEVICES > 4)
+  {COIL(4, GREEN), COIL(4, RED)},
+  {COIL(5, GREEN), COIL(5, RED)},
+  {COIL(6, GREEN), COIL(6, RED)},
+  {COIL(7, GREEN), COIL(7, RED)},
+#endif
+};
+
+#define NUMBER_OF_ROUTES  4
+#define STEPS_PER_ROUTE   4         // also: the route is not running
+#define ROUTE_CVS         6         // CVs per route: AddrL, AddrH and the steps
+#define ROUTE_DELAY_UNIT  10        // 200 ms, in 20 ms ticks
+
+
+typedef struct {
+  unsigned char gate_pos;	    // which of the two gates is currently on (RED or GREEN)
+  unsigned char hold_time;	    // maximum pulse duration to activate the gate (in 20 ms ticks)
+  unsigned char rest_time;	    // remaining puls duration during gate activation
+  unsigned char last_gate;	    // gate of the last executed command (retransmission filter)
+  unsigned char repeat_time;	    // remaining ticks in which the same command is a retransmission
+  unsigned char throw_from;	    // feedback signals when the coil fired (NOT_STABLE: not measuring)
+  unsigned char throw_ticks;	    // ticks since the coil fired
+  unsigned char pending_gate;	    // gate waiting for activation (NO_GATE: none)
+} t_device;
+
+t_device devices[NUMBER_OF_DEVICES]; // devices (switches, relays, ...) with each two coils
+
+// Throw times (in 20 ms ticks), from firing the coil till the feedback signals of the switch show
+// the new end position. Kept in RAM only; the order is the same as that of CV38..CV49.
+// Only devices 1..4 have feedback signals, so devices 5..8 (relays16) have no throw times.
+typedef struct {
+  unsigned char last[4];
+  unsigned char min[4];
+  unsigned char max[4];
+} t_throw_times;
+
+t_throw_times throw_times;
+unsigned char throw_limit;	    // CV36: throws that take longer raise an alarm (0: no alarms)
+unsigned char alarm_rs_addr;	    // CV37: RS-bus address for the alarms (0: no alarms)
+unsigned char throw_alarm;	    // bit per device: the last throw exceeded throw_limit
+unsigned char alarm_pending;	    // throw_alarm has changed, and should be send
+
+// Coil scheduler. Solenoids draw a high current, so if a route sets four switches in one burst, 
+// the booster voltage may drop. Therefore at most max_coils coils are activated at the same time.
+// Activations that have to wait are queued (in order of arrival, at most one per device) and
+// started from check_switch_time_out(), as soon as an active coil is switched off.
+unsigned char max_coils;	    // CV50: maximum number of active coils (0: no limit)
+unsigned char coil_queue[NUMBER_OF_DEVICES]; // devices waiting for activation, oldest first
+unsigned char queue_length;
+
+// Pulse engine. If CV51 (pulse_unit) is 0, the hold times (CV3..CV6) are in 20 ms ticks and the
+// coils are switched off by check_switch_time_out(), so a pulse may be up to one tick too short.
+// Otherwise the hold times are in steps of pulse_unit ms, and the coils are switched off by the 
+// Timer2 ISR (every 1 ms, see rs_bus_hardware.c), thus with 1 ms resolution.
+unsigned char pulse_unit;	    // CV51: 0 = 20 ms ticks / 1..255 = ms per step of the hold time
+unsigned int pulse_ms[NUMBER_OF_DEVICES]; // remaining pulse time in ms; only changed by the ISR once started
+volatile unsigned char coil_pulses; // bit per device: the ISR will end the pulse of this device
+
+// PWM hold mode (only if pulse_unit > 0). A coil first gets a full pull-in pulse of CV53 steps.
+// For the remainder of the hold time it is switched on and off by the Timer2 ISR, with a period
+// of 8 ms: on during hold_duty ms, off during the rest. This reduces current and heat, especially 
+// for relays that are held for a long time. With a hold time of 0 the relay is held for ever; 
+// after the pull-in pulse it no longer counts as an active coil for CV50 (coil_held).
+unsigned char hold_duty;	    // CV52: 0 = no PWM / 1..7 = ms on per 8 ms
+unsigned char pull_in;		    // CV53: pull-in time, in steps of pulse_unit ms
+unsigned int pull_ms[NUMBER_OF_DEVICES]; // remaining pull-in time in ms
+t_coils coil_mask[NUMBER_OF_DEVICES]; // the active gate (coil) of each device
+unsigned char pwm_phase;	    // 0..7, advanced each ms
+volatile unsigned char coil_held;   // bit per device: held for ever with PWM (after pull-in)
+
+// Position journal. To continue after power-up with the positions before power-down, the positions
+// of all four devices are written to EEPROM after each change. A single EEPROM cell survives about
+// 100.000 writes, therefore the positions are not written to a fixed cell, but appended to a ring
+// of entries in the EEPROM space behind the CVs. Each entry holds, besides the positions, a
+// sequence number that is one higher than that of the previous entry. The latest entry is thus the
+// one whose successor does not continue the sequence; since the number of entries is no multiple 
+// of 256, there is always such an entry. The ring has JOURNAL_SIZE = (512 - sizeof(t_cv_record)) /
+// sizeof(t_journal_entry) entries (ATmega16). With 4 devices that is (512 - 77) / 2 = 217 entries;
+// at 1000 position changes per day each cell is written less than 5 times per day, which gives
+// about 60 years. With 8 devices an entry has 3 bytes, so (512 - 77) / 3 = 145 entries, less than
+// 7 writes per cell per day and about 40 years.
+// The entry is written byte by byte (first the positions, then the sequence number), each in a 
+// different time tick, so the main loop never waits for the EEPROM. If power fails halfway, the 
+// sequence is not continued and the previous entry remains the latest one.
+// After power-up the positions of relays that are held for ever (hold time 0) are not restored, 
+// since such relays fall back once power is gone.
+// Routes. A route is triggered by an accessory command for another decoder, namely for the switch
+// number in the RouteAddr CVs (1..2048, numbered as on the handheld: RecDecAddr * 4 + RecDecPort + 1).
+// The command station thus needs to send a single command, instead of one per switch. The steps 
+// of the route (CVs RouteStep, bits DDDGPPPP) are executed one after the other: after a delay of 
+// DDD * 200 ms (counted from the previous step), device PPPP (1..8) is set to gate G. If PPPP is 0,
+// or a device this decoder does not have, the step only waits. The steps are passed to schedule_coil(), so CV50 
+// still limits the number of active coils.
+// The route table stays in EEPROM; only the switch numbers are copied to RAM (init_switch_cvs).
+unsigned int route_addr[NUMBER_OF_ROUTES];	// switch number that triggers the route (0: not used)
+unsigned char route_next[NUMBER_OF_ROUTES];	// next step to execute (STEPS_PER_ROUTE: not running)
+unsigned char route_delay[NUMBER_OF_ROUTES];	// ticks since the previous step
+unsigned char route_repeat[NUMBER_OF_ROUTES];	// ticks in which a trigger is a retransmission
+
+t_journal_entry journal[JOURNAL_SIZE] EEMEM;	// see switch.h; placed behind CV, since config.o is linked first (Makefile)
+unsigned int journal_head;	    // index of the latest entry
+unsigned char journal_seq;	    // its sequence number
+unsigned char journal_state[JOURNAL_STATE_BYTES]; // positions in (or being written to) the latest entry
+unsigned char journal_step;	    // 0: idle / 1..JOURNAL_STATE_BYTES: write that position byte / 
+				    // JOURNAL_STATE_BYTES + 1: write the sequence number
+
+// The work that is done each tick (coil hold times in ticks, retransmission windows, throw time 
+// measurement, routes, alarms and the journal) is done by check_switch_time_out(), called by a
+// periodic software timer. The timer is started (wake_switches) as soon as there is such work, and
+// stopped once all work is done. Thus an idle decoder does no switch work at all.
+t_timer switch_timer;
+void check_switch_time_out(void);
+
+void wake_switches(void) {
+  // If the timer is already running it is left alone; restarting would postpone a sweep that is due
+  if (!timer_running(&switch_timer)) start_timer(&switch_timer, check_switch_time_out, 1, 1);
+}
+
+
+//*****************************************************************************************************
+//********************************** Local functions (called locally) *********************************
+//*****************************************************************************************************
+void init_switch(unsigned char device) {
+  // device range: 0..(NUMBER_OF_DEVICES - 1)
+  // initialise the "administration" for the requested switch
+  // The position before power-down is restored afterwards from the journal (see init_switches).
+  // Although we could measure the gate position, not doing so has as only "disadvantage" that the
+  // first time the gate (switch) is activated, it may allready have been in the requested position. 
+  devices[device].gate_pos = UNKNOWN;
+  devices[device].repeat_time = 0;
+  devices[device].throw_from = NOT_STABLE;
+  devices[device].pending_gate = NO_GATE;
+  // in case of relays, initialise the gate to a default position by setting the remaining puls time
+#ifdef RELAYS_PCB
+  devices[device].rest_time = 0;
+#endif
+}
+
+// Throw time measurement. Each switch has two feedback signals (end switches). When the switch
+// moves to the other position, both signals change. The measurement therefore starts when the
+// coil fires and the feedback signals show a valid (stable, different) end position. It ends when
+// both signals have changed, or after 255 ticks (the switch is stuck). No measurement is done if
+// we don't know the current position (after start-up), or if the switch does not move.
+void start_throw_measurement(unsigned char device) {
+  unsigned char from = NOT_STABLE;
+  if (devices[device].gate_pos != UNKNOWN) from = feedback_pair(device);
+  if ((from == 0x00) || (from == 0x03)) from = NOT_STABLE;	// not in an end position
+  devices[device].throw_from = from;
+  devices[device].throw_ticks = 0;
+}
+
+void save_throw_time(unsigned char device, unsigned char ticks) {
+  if ((throw_times.last[device] == 0) || (ticks < throw_times.min[device])) throw_times.min[device] = ticks;
+  if (ticks > throw_times.max[device]) throw_times.max[device] = ticks;
+  throw_times.last[device] = ticks;
+  devices[device].throw_from = NOT_STABLE;
+}
+
+void set_throw_alarm(unsigned char device, unsigned char alarm) {
+  unsigned char old_alarm = throw_alarm;
+  if (alarm) throw_alarm |= (1<<device);
+    else throw_alarm &= ~(1<<device);
+  if (throw_alarm != old_alarm) alarm_pending = 1;
+}
+
+void check_throw(unsigned char device) {
+  // called every time tick (20 ms) for switches that are being measured
+  unsigned char ticks = devices[device].throw_ticks + 1;
+  devices[device].throw_ticks = ticks;
+  if (feedback_pair(device) == (devices[device].throw_from ^ 0x03)) {	// new end position reached
+    save_throw_time(device, ticks);
+    if ((throw_limit == 0) || (ticks < throw_limit)) set_throw_alarm(device, 0);
+  }
+  else {
+    if ((throw_limit != 0) && (ticks == throw_limit)) set_throw_alarm(device, 1);	// slow
+    if (ticks == 255) save_throw_time(device, ticks);				// stuck
+  }
+}
+
+void send_throw_alarm(void) {
+  // The alarm bits of the four switches are send as the first nibble of the alarm address.
+  // The second nibble is always 0; it is send as well, since the master expects both nibbles. 
+  // If the RS-bus is not active, or the transmit queue is full, we try again next tick. 
+  unsigned char nibble;
+  if (alarm_rs_addr == 0) {alarm_pending = 0; return;}
+  if ((RS_Layer_1_active) && (RS_queue_free() >= 2)) {
+    nibble = (((throw_alarm >> 0) & 1) << DATA_0)
+           | (((throw_alarm >> 1) & 1) << DATA_1)
+           | (((throw_alarm >> 2) & 1) << DATA_2)
+           | (((throw_alarm >> 3) & 1) << DATA_3)
+           | (0<<NIBBLE);
+    format_and_send_RS_data_nibble(alarm_rs_addr, nibble);
+    format_and_send_RS_data_nibble(alarm_rs_addr, (1<<NIBBLE));
+    alarm_pending = 0;
+  }
+}
+
+unsigned char coil_active(unsigned char device) {
+  return((devices[device].rest_time != 0) || (coil_pulses & (1<<device)));
+}
+
+unsigned char coil_available(void) {
+  // Returns 1 if another coil may be activated now
+  unsigned char i, active;
+  if (max_coils == 0) return(1);
+  active = 0;
+  for (i=0; i<NUMBER_OF_DEVICES; i++) {if (coil_active(i)) active++;}
+  return(active < max_coils);
+}
+
+static inline t_coils gate_coil(unsigned char device, unsigned char gate) __attribute__((always_inline));
+t_coils gate_coil(unsigned char device, unsigned char gate) {
+  // Returns the coil of this gate
+#if (NUMBER_OF_DEVICES > 4)
+  return(pgm_read_word(&coil_table[device][gate]));
+#else
+  return(pgm_read_byte(&coil_table[device][gate]));
+#endif
+}
+
+static inline void set_coils(t_coils off, t_coils on) __attribute__((always_inline));
+void set_coils(t_coils off, t_coils on) {
+  // Switches the coils in off off and those in on on, with a single write per port. Thus there is
+  // no moment at which only part of the coils has been switched.
+  OUTPUT_PORT = (OUTPUT_PORT & ~((unsigned char) off)) | (unsigned char) on;
+#if (NUMBER_OF_DEVICES > 4)
+  EXTENSION_PORT = (EXTENSION_PORT & ~((unsigned char) (off >> 8))) | (unsigned char) (on >> 8);
+#endif
+}
+
+void activate_coil(unsigned char device, unsigned char gate) {
+  // The Timer2 ISR may switch off other coils on the same port (run_coil_pulses). Interrupts are
+  // therefore disabled while we modify the port, otherwise our write could undo that of the ISR.
+  // The interrupt flag is restored afterwards, since we may be called before the global sei()
+  // (init_relays_to_green).
+  unsigned char sreg = SREG;
+  cli();
+  // start measuring the throw time, if the switch will move (switches 1..4 have feedback signals)
+#ifndef RELAYS_PCB
+  if ((device < 4) && (devices[device].gate_pos != gate)) start_throw_measurement(device);
+#endif
+  // select the active gate
+  devices[device].gate_pos = gate;
+  // Deactivate the other gate (coil) of this device, and activate this gate, in one write
+  coil_mask[device] = gate_coil(device, gate);
+  set_coils(gate_coil(device, GREEN) | gate_coil(device, RED), coil_mask[device]);
+  // set the activation time
+  if (pulse_unit == 0) {
+    devices[device].rest_time = devices[device].hold_time;	// in ticks; see check_switch_time_out()
+  }
+  else {
+    pulse_ms[device] = devices[device].hold_time * pulse_unit;	// in ms; see run_coil_pulses()
+    pull_ms[device] = pull_in * pulse_unit;
+    coil_held &= ~(1<<device);
+    if ((pulse_ms[device] != 0) || (hold_duty != 0)) coil_pulses |= (1<<device);
+      else coil_pulses &= ~(1<<device);
+  }
+  SREG = sreg;
+  wake_switches();				// hold time, throw measurement and journal
+}
+
+void schedule_coil(unsigned char device, unsigned char gate) {
+  // Activate the coil now if possible, otherwise queue the activation. A device that is already 
+  // active may switch to its other coil immediately, since this does not add an active coil.
+  if (devices[device].pending_gate != NO_GATE) {	// already waiting: the last command counts
+    devices[device].pending_gate = gate;
+    return;
+  }
+  if (coil_active(device) || ((queue_length == 0) && coil_available())) {
+    activate_coil(device, gate);
+  }
+  else {
+    devices[device].pending_gate = gate;
+    coil_queue[queue_length] = device;
+    queue_length++;
+  }
+}
+
+void start_queued_coils(void) {
+  // called every time tick (20 ms), after coils whose time is over have been switched off
+  unsigned char i, device;
+  while ((queue_length != 0) && coil_available()) {
+    device = coil_queue[0];
+    queue_length--;
+    for (i=0; i<queue_length; i++) coil_queue[i] = coil_queue[i+1];
+    activate_coil(device, devices[device].pending_gate);
+    devices[device].pending_gate = NO_GATE;
+  }
+}
+
+void run_coil_pulses(void) {
+  // Called every 1 ms by the Timer2 ISR, if coil_pulses or coil_held is not 0
+  // The coils to switch on and off are collected first; the ports are updated once at the end.
+  unsigned char i;
+  t_coils on = 0;
+  t_coils off = 0;
+  pwm_phase = (pwm_phase + 1) & 0x07;
+  for (i=0; i<NUMBER_OF_DEVICES; i++) {
+    if (coil_pulses & (1<<i)) {
+      if (pull_ms[i] != 0) pull_ms[i]--;		// pull-in: coil fully on
+        else if (hold_duty != 0) {			// hold: PWM
+          if (pwm_phase < hold_duty) on |= coil_mask[i]; else off |= coil_mask[i];
+        }
+      if (pulse_ms[i] != 0) {
+        pulse_ms[i]--;
+        if (pulse_ms[i] == 0) {
+          off |= coil_mask[i];				// the only gate (coil) that may be on
+          coil_pulses &= ~(1<<i);
+          events |= (1<<EV_PULSE);		// main may start queued coils
+        }
+      }
+      else if (pull_ms[i] == 0) {			// hold for ever, pull-in is over
+        coil_pulses &= ~(1<<i);
+        if (hold_duty != 0) coil_held |= (1<<i);	// (CV52 may have been cleared meanwhile)
+        events |= (1<<EV_PULSE);
+      }
+    }
+    else if (coil_held & (1<<i)) {
+      if (pwm_phase < hold_duty) on |= coil_mask[i]; else off |= coil_mask[i];
+    }
+  }
+  if (on | off) set_coils(off, on & ~off);
+}
+
+void journal_encode(unsigned char *state) {
+  // fills state with the positions of all devices, in the format of t_journal_entry.state
+  unsigned char i;
+  memset(state, 0, JOURNAL_STATE_BYTES);
+  for (i=0; i<NUMBER_OF_DEVICES; i++) {
+    if (devices[i].gate_pos == GREEN) state[i>>2] |= (1<<(2*(i & 0x03)));
+    if (devices[i].gate_pos == RED) state[i>>2] |= (2<<(2*(i & 0x03)));
+  }
+}
+
+void journal_restore(void) {
+  // Searches the latest entry in a single scan, and restores the positions it contains
+  unsigned int i;
+  unsigned char seq, next, device, pos;
+  seq = my_eeprom_read_byte(&journal[0].seq);
+  for (i=0; i<JOURNAL_SIZE-1; i++) {
+    next = my_eeprom_read_byte(&journal[i+1].seq);
+    if (next != (unsigned char)(seq + 1)) break;
+    seq = next;
+  }
+  journal_head = i;
+  journal_seq = seq;
+  for (device=0; device<JOURNAL_STATE_BYTES; device++)
+    journal_state[device] = my_eeprom_read_byte(&journal[i].state[device]);
+  journal_step = 0;
+  for (device=0; device<NUMBER_OF_DEVICES; device++) {
+    pos = (journal_state[device>>2] >> (2*(device & 0x03))) & 0x03;
+#ifdef RELAYS_PCB
+    if (devices[device].hold_time == 0) pos = 0;
+#endif
+    if (pos == 1) devices[device].gate_pos = GREEN;
+    if (pos == 2) devices[device].gate_pos = RED;
+  }
+}
+
+unsigned char journal_update(void) {
+  // called every time tick (20 ms). Appends an entry if the positions have changed. Changes that
+  // occur while an entry is being written are combined in the next entry.
+  // Returns 0 if the journal holds the current positions, thus no further ticks are needed.
+  unsigned char state[JOURNAL_STATE_BYTES];
+  if (journal_step == 0) {
+    journal_encode(state);
+    if (memcmp(state, journal_state, JOURNAL_STATE_BYTES) == 0) return(0);
+    memcpy(journal_state, state, JOURNAL_STATE_BYTES);
+    journal_head++;
+    if (journal_head == JOURNAL_SIZE) journal_head = 0;
+    journal_seq++;
+    journal_step = 1;
+  }
+  if (!eeprom_is_ready()) return(1);		// a previous write (perhaps of a CV) is still busy
+  if (journal_step <= JOURNAL_STATE_BYTES) {
+    my_eeprom_write_byte(&journal[journal_head].state[journal_step - 1], journal_state[journal_step - 1]);
+    journal_step++;
+  }
+  else {
+    my_eeprom_write_byte(&journal[journal_head].seq, journal_seq);
+    journal_step = 0;				// next tick: check for changes during the write
+  }
+  return(1);
+}
+
+void move_device(unsigned char device, unsigned char gate) {
+  // Activates the coil, unless the device is already in that position (see also set_switch())
+  if ((devices[device].gate_pos != gate) || (cv_shadow.AlwaysAct != 0)) { 
+    activity_led();
+    schedule_coil(device, gate);		// now, or once fewer than CV50 coils are active
+  }
+}
+
+void init_routes(void) {
+  unsigned char r;
+  for (r=0; r<NUMBER_OF_ROUTES; r++) {
+    route_next[r] = STEPS_PER_ROUTE;
+    route_repeat[r] = 0;
+  }
+}
+
+unsigned char run_routes(void) {
+  // called every time tick (20 ms). Returns 0 if no route is running or in its retransmission window
+  unsigned char r, step, device;
+  unsigned char busy = 0;
+  for (r=0; r<NUMBER_OF_ROUTES; r++) {
+    if (route_repeat[r]) route_repeat[r]--;
+    while (route_next[r] < STEPS_PER_ROUTE) {
+      step = my_eeprom_read_byte(&CV.Route1Step1 + r * ROUTE_CVS + route_next[r]);
+      if (step == 0) {				// end of the route
+        route_next[r] = STEPS_PER_ROUTE;
+        break;
+      }
+      if (route_delay[r] < (step >> 5) * ROUTE_DELAY_UNIT) {
+        route_delay[r]++;
+        break;
+      }
+      device = step & 0x0F;			// 1..8; 0: no device
+      if ((device != 0) && (device <= NUMBER_OF_DEVICES)) move_device(device - 1, (step >> 4) & 0x01);
+      route_delay[r] = 0;
+      route_next[r]++;
+    }
+    busy |= route_repeat[r] | (route_next[r] < STEPS_PER_ROUTE);
+  }
+  return(busy);
+}
+
+// Relays that are held for ever (hold time 0) drop out at power-down, so the journal does not
+// restore their position. The routine below, called at start-up, sets these relays to GREEN. The
+// activations are scheduled, thus they are performed one after the other if CV50 is 1, without
+// blocking the main loop.
+void init_relays_to_green(void) {
+  unsigned char device;
+  for (device=0; device<NUMBER_OF_DEVICES; device++) {
+    if (devices[device].hold_time == 0) schedule_coil(device, GREEN);
+  }
+}
+
+//*****************************************************************************************************
+//********************************* Main functions (called externally) ********************************
+//*****************************************************************************************************
+void init_switch_cvs(void) {
+  // Copies the CVs used by this module into RAM. Called by init_switches() and, after each CV
+  // write, by cv_pom.c, so new values take effect without a restart. Coils that are active keep
+  // their current pulse; the new hold times, pulse unit and pull-in time apply from the next one.
+  unsigned char i, sreg;
+  t_coils on = 0;
+  // store the maximum puls time. Devices 5..8 use the same CVs (CV3..CV6) as devices 1..4
+  for (i=0; i<NUMBER_OF_DEVICES; i++) devices[i].hold_time = my_eeprom_read_byte(&CV.T_on_F1 + (i & 0x03));
+  // Throw time measurement and alarms (switch decoders only)
+  throw_limit = my_eeprom_read_byte(&CV.ThrowLimit);
+  alarm_rs_addr = my_eeprom_read_byte(&CV.AlarmRsAddr);
+  if (alarm_rs_addr > 128) alarm_rs_addr = 0;
+  // Maximum number of coils that may be active at the same time
+  max_coils = my_eeprom_read_byte(&CV.MaxCoils);
+  // Unit of the hold times; if not 0, the Timer2 ISR ends the pulses
+  pulse_unit = my_eeprom_read_byte(&CV.PulseUnit);
+  // PWM hold mode; needs the pulse engine (pulse_unit > 0). hold_duty and coil_held are used by
+  // the Timer2 ISR, so interrupts are disabled. If PWM is switched off, coils in their PWM phase
+  // are switched fully on, just as coils that are held without PWM.
+  sreg = SREG;
+  cli();
+  hold_duty = my_eeprom_read_byte(&CV.HoldDuty);
+  if ((pulse_unit == 0) || (hold_duty > 7)) hold_duty = 0;
+  if (hold_duty == 0) {
+    for (i=0; i<NUMBER_OF_DEVICES; i++) {if ((coil_held | coil_pulses) & (1<<i)) on |= coil_mask[i];}
+    coil_held = 0;
+    if (on) set_coils(0, on);
+  }
+  pull_in = my_eeprom_read_byte(&CV.PullIn);
+  SREG = sreg;
+  // The switch numbers that trigger the routes; the steps are read from EEPROM when needed
+  for (i=0; i<NUMBER_OF_ROUTES; i++) {
+    route_addr[i] = my_eeprom_read_byte(&CV.Route1AddrL + i * ROUTE_CVS) 
+                  | ((my_eeprom_read_byte(&CV.Route1AddrH + i * ROUTE_CVS) & 0x07) << 8);
+  }
+}
+
+void init_switches(void) {
+  unsigned char i;
+  // first disable all outputs
+  OUTPUT_PORT = 0x00;
+#if (NUMBER_OF_DEVICES > 4)
+  EXTENSION_PORT = 0x00;
+#endif
+  // initialise for all switches the "administration"
+  // continue from the last switches positions before power-down.
+  for (i=0; i<NUMBER_OF_DEVICES; i++) init_switch(i);
+  coil_pulses = 0;
+  coil_held = 0;
+  init_switch_cvs();
+  journal_restore();
+  init_routes();
+  throw_alarm = 0;
+  alarm_pending = 0;
+  queue_length = 0;
+  // relays without a restored position are set to a predefined position (GREEN)
+#ifdef RELAYS_PCB
+  init_relays_to_green();
+#endif
+  // 
+  // Determine of coils should only be activated in case their position has changed, or if they 
+  // should allways be activated after reception of a Accesory Decoder command. In the later case 
+  // the coil will be activated again for each retranmission, or in case of a handheld as long as
+  // the + or - button is pushed.
+  // Note that, in case of AlwaysAct, a Feedback message will be generated even in case the switch 
+  // has not changed. Some programs, such as Railware, expect such behavior.
+  // The AlwaysAct CV is read from its RAM copy (cv_shadow), which is loaded by init_cv_shadow().
+}
+
+
+void set_switch(void) { 
+  // This function is called from main, after a DCC accessory decoder command  
+  // or a loco F1..F4 command is received
+  // We do timer-based de-activation, so no need to react on de-activation messages 
+  if (TargetActivate) {
+    // Ignore retransmissions of the command we executed last for this device. Without this,
+    // AlwaysAct would fire the coil (and cause feedback traffic) for every copy of the same command.
+    // A command that is still repeated after REPEAT_WINDOW (such as a handheld button that stays
+    // pushed) is executed again, so AlwaysAct keeps its meaning.
+    if ((devices[TargetDevice].repeat_time != 0) && (devices[TargetDevice].last_gate == TargetGate)) return;
+    devices[TargetDevice].last_gate = TargetGate;
+    devices[TargetDevice].repeat_time = REPEAT_WINDOW;
+    wake_switches();				// counts down repeat_time
+    // Always react, even if the current gate position is the same as the requested position
+    // This ensures that the coil will always be activated, and a feedback message being send
+    // As a consequence, the coil may receive many pulses in a row
+    move_device(TargetDevice, TargetGate);
+  }
+} 
+
+
+void set_route(void) { 
+  // This function is called from main, after a DCC accessory command for another decoder.
+  // Only basic accessory commands can trigger a route. A route is started for the first command;
+  // the retransmissions that follow within REPEAT_WINDOW are ignored.
+  unsigned int number;
+  unsigned char r;
+  if ((MyConfig != 0) || (TargetActivate == 0)) return;
+  number = (RecDecAddr << 2) + RecDecPort + 1;
+  for (r=0; r<NUMBER_OF_ROUTES; r++) {
+    if (route_addr[r] == number) {
+      if (route_repeat[r] == 0) {
+        route_next[r] = 0;
+        route_delay[r] = 0;
+      }
+      route_repeat[r] = REPEAT_WINDOW;
+      wake_switches();				// runs the route
+    }
+  }
+} 
+
+
+void check_switch_time_out(void) { 
+  // This function is called from main by switch_timer, every time tick (20 ms) as long as there
+  // is work to do. If all work is done, the timer is stopped. 
+  unsigned char i;
+  unsigned char rest_ticks;
+  unsigned char busy = 0;
+  unsigned char sreg;
+  t_coils off = 0;				// coils whose time is over
+  for (i=0; i<NUMBER_OF_DEVICES; i++) {		// check each device (relays, switch, ...)
+    if (devices[i].repeat_time) devices[i].repeat_time--;	// retransmission window
+    if (devices[i].throw_from != NOT_STABLE) check_throw(i);	// throw time measurement
+    rest_ticks = devices[i].rest_time;		// use a local variable to force compiler to tiny code
+    if (rest_ticks !=0) {			// coil is active / active time is not over yet
+      rest_ticks = rest_ticks - 1;		// decrease remaining time coil should still be active
+      if (rest_ticks == 0) off |= coil_mask[i];	// coil should no longer be active
+      devices[i].rest_time = rest_ticks;
+    }
+    busy |= devices[i].repeat_time | rest_ticks | (devices[i].throw_from != NOT_STABLE);
+  }
+  if (off) {					// all coils in one sweep
+    sreg = SREG;				// the Timer2 ISR (run_coil_pulses) writes the same ports
+    cli();
+    set_coils(off, 0);
+    SREG = sreg;
+  }
+  busy |= run_routes();
+  start_queued_coils();
+  if (alarm_pending) send_throw_alarm();
+  busy |= journal_update();
+  if (!busy && !alarm_pending && (queue_length == 0)) stop_timer(&switch_timer);
+}
+
+
+unsigned char throw_time(unsigned char index) {
+  // Returns CV38 + index (index range: 0..11)
+  return(((unsigned char *) &throw_times)[index]);
+}
+
@@ -1,14 +1,32 @@
-//-------------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
-// 
-//-------------------------------------------------------------------------------
-#pragma once
-
-void init_switches(void);				// called from main
-void set_switch(void);				// called from main 
-void check_switch_time_out(void);		// called from main
-
+//-------------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+// 
+//-------------------------------------------------------------------------------
+#pragma once
+
+void init_switches(void);				// called from main
+void init_switch_cvs(void);			// called from cv_pom, after a CV write
+void set_switch(void);				// called from main 
+void set_route(void);				// called from main, for accessory commands of other decoders
+unsigned char throw_time(unsigned char index);	// called from cv_pom (CV38..CV49)
+
+extern volatile unsigned char coil_pulses;	// coils whose pulse is ended by run_coil_pulses()
+extern volatile unsigned char coil_held;	// coils that are held for ever with PWM
+void run_coil_pulses(void);			// called from the Timer2 ISR, each 1 ms (pulses, PWM)
+void start_queued_coils(void);			// called from main, after a pulse ended
+
+// Position journal in EEPROM (see switch.c)
+#define JOURNAL_STATE_BYTES ((NUMBER_OF_DEVICES + 3) / 4)
+
+typedef struct {
+  unsigned char seq;		    // sequence number
+  unsigned char state[JOURNAL_STATE_BYTES]; // 2 bits per device: 01 = GREEN, 10 = RED, 00 or 11 = UNKNOWN
+} t_journal_entry;
+
+#define JOURNAL_SIZE      ((EEPROM_SIZE - sizeof(t_cv_record)) / sizeof(t_journal_entry))
+
+extern t_journal_entry journal[JOURNAL_SIZE];
@@ -1,342 +1,444 @@
-//*****************************************************************************************************
-//
-// OpenDCC - OpenDecoder2.2
-//
-// Copyright (c) 2011,2013 Pras
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
-// 
-//*****************************************************************************************************
-//
-// file:      switch_feedback.c
-// author:    Aiko Pras
-// history:   2013-12-31 V0.1 ap Initial version (based on earlier rs_bus_port.c)
-//            2015-01-06 V0.2 ap Since switches are now counted from left to right, the order of
-//                               needed to be changes as well. In addition, in case of SkipUnEven
-//                               feedback bits of even AND uneven switches are now returned
-//
-//
-// Routines for determining switch positions, which will be send via RS-Bus feedback messages
-// to a LENZ Command Station
-//
-//
-//*****************************************************************************************************
-#include <stdlib.h>
-#include <stdbool.h>
-#include <inttypes.h>
-#include <avr/pgmspace.h>	// put var to program memory
-#include <avr/io.h>		// needed for UART
-#include <avr/eeprom.h>
-#include <avr/interrupt.h>
-#include <util/parity.h>	// Needed to calculate the parity bit
-
-#include "global.h"		// global variables
-#include "config.h"		// general definitions the decoder, cv's
-#include "myeeprom.h"           // wrapper for eeprom
-#include "hardware.h"		// port definitions for target
-#include "rs_bus_hardware.h"	// hardware related RS-bus functions (layer 1 / physical layer)
-#include "rs_bus_messages.h"	// RS-bus layer 2 functions / defines of bit positions
-
-#include "main.h"
-
-//************************************************************************************************
-// Define global variables
-//************************************************************************************************
-unsigned char skip_uneven_addresses; // use only even addresses, to solve potential feedback issues
-unsigned char RS_tranmissions;       // number of times a RS-bus message is transmitted
-struct
-  {
-    unsigned char samples;	     // buffer to store 8 consequtive samples, to filter glitches
-    unsigned char previous_position; // this position has previously been send to the master
-    unsigned char next_position;     // this position will be send to the master
-    unsigned char stable;	     // 0: samples are different / 1: all samples are equal
-    unsigned char to_send;	     // 0: no changes => no need to send 
-                                     // >1: changed => needs to be send / Note: a higher value is
-    				     // used to transmit multiple times (forward error correction)
-  } feedback[8];		     // we have eight feedback signals (two per switch)
- 
- 
-//************************************************************************************************
-// init_switch_feedback will be directly called from main externally
-//************************************************************************************************
-void init_switch_feedback(void)
-{ // Step 1: check if a nibble should hold feedbacks for a single switch, or for two switches
-  // If the nibble should hold info for a single switch only, even addresses should not be used 
-  skip_uneven_addresses = my_eeprom_read_byte(&CV.SkipUnEven);   // CV21                
-  // Step 2: Determine number of times the same RS-feedback nibble will be transmitted
-  // Minimum is 1, but if CV537 > 0 the nibble will be retransmitted (forward error correction)
-  RS_tranmissions = 1 + my_eeprom_read_byte(&CV.RSRetry);   // CV20  
-  // Step 3: Make RS_Addr2Use zero. Will be set by the RS_connect / send_feedbacks routines
-  RS_Addr2Use = 0; 
-}
-
-
-//************************************************************************************************
-// Next routines are used to read the values from the eigth feedback pins,
-// to test if all pins are stable, to test if some pins are changed and to save the changes
-//************************************************************************************************
-void read_feedbacks(void)
-{
-  unsigned char new_sample, i;
-  // Basic operation: maintain, per feedback signal, eight consequtive samples. If all these
-  // samples have the same value (0x00 or 0xFF), the feedback signal is considered to be stable.
-  // Step 1: Shift the bits in each of the eigth feedback variables one to the left.
-  // In this way we collect 7 consequtive samples (note: newest bit at the right will be zero). 
-  for (i = 0; i < 8; i++) { feedback[i].samples = (feedback[i].samples << 1);}
-  // Step 2: Give the newest bit at the right a value. Read therefore the input port for feedbacks
-  new_sample = FEEDBACK_IN;
-  feedback[0].samples |= ((new_sample & 0x01) >> 0);	// bit 0
-  feedback[1].samples |= ((new_sample & 0x02) >> 1);	// bit 1
-  feedback[2].samples |= ((new_sample & 0x04) >> 2);	// bit 2
-  feedback[3].samples |= ((new_sample & 0x08) >> 3);	// bit 3
-  feedback[4].samples |= ((new_sample & 0x10) >> 4);	// bit 4
-  feedback[5].samples |= ((new_sample & 0x20) >> 5);	// bit 5
-  feedback[6].samples |= ((new_sample & 0x40) >> 6);	// bit 6
-  feedback[7].samples |= ((new_sample & 0x80) >> 7);	// bit 7
-  // Step 3: Check if all samples of each feedback signal are stable (samples are 0x00 or 0xFF)
-  // If they have the same value, and if this value is different from the value that was previously
-  // been send to the master, we set the changed flag and fill in the next_position
-  for (i = 0; i < 8; i++) 
-  {
-    if ((feedback[i].samples == 0x00) || (feedback[i].samples == 0xFF))
-    {
-      feedback[i].stable = 1;
-      if ((feedback[i].samples == 0x00) && (feedback[i].previous_position != 0x00))
-      {
-        feedback[i].next_position = 0x00;
-        feedback[i].to_send = RS_tranmissions;
-      }
-      if ((feedback[i].samples == 0xFF) && (feedback[i].previous_position == 0x00))
-      {
-        feedback[i].next_position = 0x01;
-        feedback[i].to_send = RS_tranmissions;
-      }
-    }
-    else {feedback[i].stable = 0;}
-  }
-}
-
-
-unsigned char stable(unsigned char start, unsigned char end)
-{
-  // The previous function "read_feedbacks" tested stability for each individual feedback signal
-  // This function tests if all feedback signals between "start" and "end" are stable
-  unsigned char i, result;
-  result = 1;                         // initial assumption: all feedback signals are stable
-  for (i = start; i <= end; i++) {    // does this assumption hold for all feedback signals?
-    if (feedback[i].stable != 1) {result = 0;} }
-  return result;
-}
-
-
-unsigned char changed(unsigned char start, unsigned char end)
-{
-  // The function "read_feedbacks" tested and set "changed" for each individual feedback signal
-  // Clearing "changed" is done by the functions responsible for transmission via the RS-bus
-  // This function tests if one or more feedback signals between "start" and "end" have changed
-  unsigned char i, result;
-  result = 0;                         // initial assumption: no feedback signal has changed
-  for (i = start; i <= end; i++) {    // does this assumption hold for all feedback signals?
-    if (feedback[i].to_send > 0) {result = 1;} }
-  return result;
-}
-
-
-void save_changes(unsigned char start, unsigned char end)
-{
-  // This function saves the changes for the feedbacks between "start" and "end"
-  // after the nibble to which they belong has been send to the master
-  unsigned char i;
-  for (i = start; i <= end; i++) { 
-    feedback[i].previous_position = feedback[i].next_position;
-    if (feedback[i].to_send > 0)   {feedback[i].to_send --;} }
-}
-
-
-//************************************************************************************************
-// The next routine is used to connect to the master
-//************************************************************************************************
-void RS_connect(void)
-{
-  // Register feedback module: send low and high order nibble in 2 consequtive cycles
-  // In case we use two addresses, we should repeat this for the second address
-  // Note that interference on the AVR's input lines during AVR restart requires us 
-  // to wait till all feedback signals have become stable. Note that spurious resets on the
-  // AVR 644A have also been detected (the AVR signals "brown-out" reset, although no power
-  // problems can be measured), which means that the AVR can also be restarted during normal
-  // operation. Therefore we have to make sure we always send correct (thus stable) values.
-  unsigned char nibble;
-  if ((RS_Layer_1_active) && stable(0,7))  // wait till RS-bus is active and feedback stable
-  {
-    if (skip_uneven_addresses)
-    { // We use two feedback addresses or, in case of switches, 8 (instead of 4) switch addresses
-      // send first nibble, first address
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr;
-      nibble = (feedback[0].next_position<<DATA_1)
-             | (feedback[1].next_position<<DATA_0)
-             | (0<<DATA_3)
-             | (0<<DATA_2)
-             | (0<<NIBBLE);
-      save_changes(0,1);
-      format_and_send_RS_data_nibble(nibble);      
-      // send second nibble, first address
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr;
-      nibble = (feedback[2].next_position<<DATA_1)
-             | (feedback[3].next_position<<DATA_0)
-             | (0<<DATA_3)
-             | (0<<DATA_2)
-             | (1<<NIBBLE);             
-      save_changes(2,3);
-      format_and_send_RS_data_nibble(nibble);
-      // send first nibble, second address
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr + 1;
-      nibble = (feedback[4].next_position<<DATA_1)
-             | (feedback[5].next_position<<DATA_0)
-             | (0<<DATA_3)
-             | (0<<DATA_2)
-             | (0<<NIBBLE);
-      save_changes(4,5);
-      format_and_send_RS_data_nibble(nibble);      
-      // send second nibble, second address
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr + 1;
-      nibble = (feedback[6].next_position<<DATA_1)
-             | (feedback[7].next_position<<DATA_0)
-             | (0<<DATA_3)
-             | (0<<DATA_2)
-             | (1<<NIBBLE);             
-      save_changes(6,7);
-      format_and_send_RS_data_nibble(nibble);
-    }
-    else
-    { // we use a single feedback address for all 8 feedback signals (thus four switches)
-      // send first nibble
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr;
-      nibble = (feedback[0].next_position<<DATA_1)
-             | (feedback[1].next_position<<DATA_0)
-             | (feedback[2].next_position<<DATA_3)
-             | (feedback[3].next_position<<DATA_2)
-             | (0<<NIBBLE);
-      save_changes(0,3);
-      format_and_send_RS_data_nibble(nibble);      
-      // send second nibble
-      while (RS_data2send_flag) {};	// busy wait, till the USART ISR has send previous data
-      RS_Addr2Use = My_RS_Addr;
-      nibble = (feedback[4].next_position<<DATA_1)
-             | (feedback[5].next_position<<DATA_0)
-             | (feedback[6].next_position<<DATA_3)
-             | (feedback[7].next_position<<DATA_2)
-             | (1<<NIBBLE);             
-      save_changes(4,7);
-      format_and_send_RS_data_nibble(nibble);
-    }
-    RS_Layer_2_connected = 1;		// This module should now be connected to the master station
-  }
-}
-
-
-//************************************************************************************************
-// Next routines are used to send the values from the eigth feedback pins
-//************************************************************************************************
-void send_feedbacks(void)
-{ // We send a feedback nibble to the master station if:
-  // 1: the USART has completed transmission of the previous data
-  // 2A: all feedback signals belonging to that nibble are stable, and
-  // 2B: at least one of the feedback signals of that nibble has changed
-  // Depending on whether we "skip_uneven_addresses", the nibble contains the feedback signals
-  // of one switch (we skip uneven addresses), or two switches (we do not skip addresses).
-  // With "slow switches", such as those driven by a motor, the first feedback signal may be
-  // changed a few seconds before the second is changed. As a consequence, for a limited period,
-  // both feedback signals of a switch (switch is red / green) may be high (or low).
-  // After a short time, however, only one of them will remain high (or low).
-  unsigned char nibble;
-  // check if we may send data (thus the USART has completed transmission of the previous data)
-  if (RS_data2send_flag == 0) { 
-    // Check if we use 2 feedback addresses or, for switches, 8 (instead of 4) switch addresses
-    if (skip_uneven_addresses) { 
-      if (stable(0,1) && changed(0,1)) {
-        RS_Addr2Use = My_RS_Addr;
-        nibble = (feedback[0].next_position<<DATA_1)
-               | (feedback[1].next_position<<DATA_0)
-               | (feedback[0].next_position<<DATA_3)
-               | (feedback[1].next_position<<DATA_2)
-               | (0<<NIBBLE);
-        save_changes(0,1);
-        format_and_send_RS_data_nibble(nibble);
-      } // if (stable(0,1)  ...
-      else if (stable(2,3) && changed(2,3)) {
-        RS_Addr2Use = My_RS_Addr;
-        nibble = (feedback[2].next_position<<DATA_1)
-               | (feedback[3].next_position<<DATA_0)
-               | (feedback[2].next_position<<DATA_3)
-               | (feedback[3].next_position<<DATA_2)
-               | (1<<NIBBLE);             
-        save_changes(2,3);
-        format_and_send_RS_data_nibble(nibble);
-      } // if (stable(2,3)  ...
-      else if (stable(4,5) && changed(4,5)) {
-        RS_Addr2Use = My_RS_Addr + 1;
-        nibble = (feedback[4].next_position<<DATA_1)
-               | (feedback[5].next_position<<DATA_0)
-               | (feedback[4].next_position<<DATA_3)
-               | (feedback[5].next_position<<DATA_2)
-               | (0<<NIBBLE);             
-        save_changes(4,5);
-        format_and_send_RS_data_nibble(nibble);
-      } // if (stable(4,5)  ...
-      else if (stable(6,7) && changed(6,7)) {
-        RS_Addr2Use = My_RS_Addr + 1;
-        nibble = (feedback[6].next_position<<DATA_1)
-               | (feedback[7].next_position<<DATA_0)
-               | (feedback[6].next_position<<DATA_3)
-               | (feedback[7].next_position<<DATA_2)
-               | (1<<NIBBLE);             
-        save_changes(6,7);
-        format_and_send_RS_data_nibble(nibble);
-      } // if (stable(6,7)  ...
-    } // if (skip_uneven_addresses)
-    else
-    { // we use a single feedback address for all 8 feedback signals (thus four switches)
-      if (stable(0,3) && changed(0,3)) {
-        RS_Addr2Use = My_RS_Addr;
-        nibble = (feedback[0].next_position<<DATA_1)
-               | (feedback[1].next_position<<DATA_0)
-               | (feedback[2].next_position<<DATA_3)
-               | (feedback[3].next_position<<DATA_2)
-               | (0<<NIBBLE);
-        save_changes(0,3);
-        format_and_send_RS_data_nibble(nibble);
-      } // if (stable(0,3)  ...
-      else if (stable(4,7) && changed(4,7)) {
-        RS_Addr2Use = My_RS_Addr;
-        nibble = (feedback[4].next_position<<DATA_1)
-               | (feedback[5].next_position<<DATA_0)
-               | (feedback[6].next_position<<DATA_3)
-               | (feedback[7].next_position<<DATA_2)
-               | (1<<NIBBLE);             
-        save_changes(4,7);
-        format_and_send_RS_data_nibble(nibble);
-      } // else if stable(4,7)  ...
-    }   // else  
-  }     // if (RS_data2send_flag == 0)
-}
-
-
-//************************************************************************************************
-// This routine is called from main every 20 milliseconds (to avoid processor overload / debounce)
-//************************************************************************************************
-void send_switch_feedback(void)
-{ // Check if My_RS_Addr is initialised
-  if (My_RS_Addr > 0) {
-    read_feedbacks();   
-    if (RS_Layer_2_connected == 0) {RS_connect();}	// Try to connect
-      else {send_feedbacks();}
-  }
-}
-
-
+//*****************************************************************************************************
+//
+// OpenDCC - OpenDecoder2.2
+//
+// Copyright (c) 2011,2013 Pras
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at http://www.gnu.org/licenses/gpl.txt
+// 
+//*****************************************************************************************************
+//
+// file:      switch_feedback.c
+// author:    Aiko Pras
+// history:   2013-12-31 V0.1 ap Initial version (based on earlier rs_bus_port.c)
+//            2015-01-06 V0.2 ap Since switches are now counted from left to right, the order of
+//                               needed to be changes as well. In addition, in case of SkipUnEven
+//                               feedback bits of even AND uneven switches are now returned
+//            2026-10-16 V0.3    Nibbles are added to the RS-bus transmit queue; no more busy waiting
+//                               RS_connect is a state machine that queues one nibble per step
+//                               Feedbacks can be sampled each 1ms, with a debounce depth set by CV35
+//                               Vertical counter debouncer; positions are kept as bit masks
+//                               feedback_pair() gives switch.c the feedback signals of a switch
+//                               feedback_sampled removed; the Timer2 ISR sets EV_FEEDBACK instead
+//                               Slow sampling (CV35 = 0) is done by a software timer (sample_timer)
+//                               CV35 is reloaded after a CV write (init_feedback_sampling)
+//                               sample_feedbacks() tells the Timer2 ISR if there is work for main
+//
+//
+// Routines for determining switch positions, which will be send via RS-Bus feedback messages
+// to a LENZ Command Station
+//
+//
+//*****************************************************************************************************
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <avr/pgmspace.h>	// put var to program memory
+#include <avr/io.h>		// needed for UART
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/parity.h>	// Needed to calculate the parity bit
+
+#include "global.h"		// global variables
+#include "config.h"		// general definitions the decoder, cv's
+#include "myeeprom.h"           // wrapper for eeprom
+#include "hardware.h"		// port definitions for target
+#include "timer1.h"		// software timer for slow sampling
+#include "rs_bus_hardware.h"	// hardware related RS-bus functions (layer 1 / physical layer)
+#include "rs_bus_messages.h"	// RS-bus layer 2 functions / defines of bit positions
+#include "switch_feedback.h"
+
+#include "main.h"
+
+//************************************************************************************************
+// Define global variables
+//************************************************************************************************
+unsigned char skip_uneven_addresses; // use only even addresses, to solve potential feedback issues
+unsigned char RS_tranmissions;       // number of times a RS-bus message is transmitted
+unsigned char connect_step;          // next nibble to be send by RS_connect()
+unsigned char feedback_fast;         // 1: feedbacks are sampled each ms by the Timer2 ISR
+t_timer sample_timer;                // 0: sample_tick() samples each 20ms tick
+void sample_tick(void);
+
+// Debouncing is done with a vertical counter: bit i of count_0, count_1 and count_2 together form
+// a 3 bit counter for feedback signal i. In this way all eight signals are handled in parallel,
+// with a few byte wide logic operations. The counter is loaded with (debounce depth - 1) if the
+// signal changes, and counts down to zero for each sample that equals the previous one.
+// A signal is stable if its counter is zero, thus if the last "depth" samples were equal.
+volatile unsigned char fb_level;     // last sample of the eight feedback signals
+volatile unsigned char fb_stable;    // 1: signal is stable / 0: signal is bouncing
+unsigned char count_0, count_1, count_2;   // vertical counter (bit 0, 1 and 2)
+unsigned char load_0, load_1, load_2;      // value loaded after a change: depth - 1 (0x00 or 0xFF)
+
+// Positions per feedback signal (one bit per signal) and retransmissions per pair of signals
+unsigned char fb_previous;           // this position has previously been send to the master
+unsigned char fb_next;               // this position will be send to the master
+unsigned char fb_to_send;            // 0: no changes => no need to send / 1: needs to be send
+unsigned char retries[4];            // per pair of signals: number of times the nibble must still be
+                                     // send. A higher value than 1 is used to transmit multiple 
+                                     // times (forward error correction)
+
+// Bit mask for the feedback signals "start" till "end"
+static inline unsigned char fb_mask(unsigned char start, unsigned char end) __attribute__((always_inline));
+unsigned char fb_mask(unsigned char start, unsigned char end)
+{
+  return((0xFF >> (7 - end)) & (0xFF << start));
+}
+
+// Position of feedback signal i that will be send to the master (0 or 1)
+static inline unsigned char next_position(unsigned char i) __attribute__((always_inline));
+unsigned char next_position(unsigned char i)
+{
+  return((fb_next >> i) & 0x01);
+}
+ 
+ 
+//************************************************************************************************
+// init_switch_feedback will be directly called from main externally
+//************************************************************************************************
+void init_feedback_sampling(void)
+{ // Determine how the feedback signals are sampled (CV35). Called by init_switch_feedback() and,
+  // after each CV write, by cv_pom.c. The debounce state is kept; a new depth applies to the next
+  // change of a signal. (The Timer2 ISR may sample while load_x is changed; the counter of a signal
+  // that changes just then gets a mix of the old and new depth, which is still a valid count.)
+  // 0: each 20ms tick, all 8 samples must be equal (thus at least 160ms before a change is stable)
+  // 1..8: each 1ms by the Timer2 ISR, the last 1..8 samples must be equal
+  unsigned char depth;
+  depth = my_eeprom_read_byte(&CV.FBDebounce);
+  feedback_fast = (depth > 0);
+  if ((depth == 0) || (depth > 8)) {depth = 8;}
+  depth = depth - 1;
+  load_0 = (depth & 0x01) ? 0xFF : 0x00;
+  load_1 = (depth & 0x02) ? 0xFF : 0x00;
+  load_2 = (depth & 0x04) ? 0xFF : 0x00;
+  // Without fast sampling, sample_tick() takes a sample each 20ms tick
+  if (Have_Feedback && !feedback_fast) {
+    if (!timer_running(&sample_timer)) start_timer(&sample_timer, sample_tick, 1, 1);
+  }
+  else stop_timer(&sample_timer);
+}
+
+
+void init_switch_feedback(void)
+{ // Step 1: check if a nibble should hold feedbacks for a single switch, or for two switches
+  // If the nibble should hold info for a single switch only, even addresses should not be used 
+  skip_uneven_addresses = my_eeprom_read_byte(&CV.SkipUnEven);   // CV21                
+  // Step 2: Determine number of times the same RS-feedback nibble will be transmitted
+  // Minimum is 1, but if CV537 > 0 the nibble will be retransmitted (forward error correction)
+  RS_tranmissions = 1 + my_eeprom_read_byte(&CV.RSRetry);   // CV20  
+  // Step 3: RS_connect() starts with the first nibble
+  connect_step = 0;
+  // Step 4: Determine how the feedback signals are sampled (CV35), and start sampling
+  init_feedback_sampling();
+  // Step 5: After a (re)start no signal is stable, and all positions are unknown (0)
+  count_0 = load_0;
+  count_1 = load_1;
+  count_2 = load_2;
+  fb_level = 0;
+  fb_stable = ~(count_0 | count_1 | count_2);
+  fb_previous = 0;
+  fb_next = 0;
+  fb_to_send = 0;
+}
+
+
+//************************************************************************************************
+// Next routines are used to read the values from the eigth feedback pins,
+// to test if all pins are stable, to test if some pins are changed and to save the changes
+//************************************************************************************************
+unsigned char sample_feedbacks(void)
+{
+  // This routine takes a sample; it is called each 20ms tick from main or, if CV35 > 0, each 1ms
+  // from the Timer2 ISR (rs_bus_hardware.c). read_feedbacks() evaluates the result.
+  // Returns 1 if send_switch_feedback() has work to do: a stable signal differs from the position
+  // send to the master, a nibble still has to be (re)transmitted (fb_to_send, also if the RS-bus
+  // queue was full), or the decoder is not yet connected (RS_connect). The Timer2 ISR only wakes
+  // up main (EV_FEEDBACK) in that case, instead of each 1ms. Without an RS-bus master or without
+  // an RS-bus address (CV10 = 0) nothing can be sent, so 0 is returned.
+  unsigned char new_sample, changes, borrow;
+  new_sample = FEEDBACK_IN;
+  changes = new_sample ^ fb_level;
+  // Step 1: Count down the counters that are not zero, for signals that did not change
+  borrow = ~changes & (count_0 | count_1 | count_2);
+  count_0 ^= borrow;
+  borrow &= count_0;			// bit 0 went from 0 to 1: borrow from bit 1
+  count_1 ^= borrow;
+  borrow &= count_1;
+  count_2 ^= borrow;
+  // Step 2: Load the counters of the signals that changed
+  count_0 = (count_0 & ~changes) | (load_0 & changes);
+  count_1 = (count_1 & ~changes) | (load_1 & changes);
+  count_2 = (count_2 & ~changes) | (load_2 & changes);
+  // Step 3: Publish the results. fb_level must be written first; see read_feedbacks()
+  fb_level = new_sample;
+  fb_stable = ~(count_0 | count_1 | count_2);
+  if (!RS_Layer_1_active || (My_RS_Addr == 0)) return(0);
+  return((fb_stable & (new_sample ^ fb_previous)) || fb_to_send || !RS_Layer_2_connected);
+}
+
+
+void sample_tick(void)
+{
+  // Called from main by sample_timer each 20ms tick, if the Timer2 ISR does not sample (CV35 = 0)
+  sample_feedbacks();
+  send_switch_feedback();
+}
+
+
+void read_feedbacks(void)
+{
+  // For all stable signals: if the position is different from the value that was previously
+  // been send to the master, we set the changed flag and fill in the next_position.
+  // Note: the Timer2 ISR may take a sample in between reading fb_level and fb_stable. Since 
+  // fb_level is read first, a signal that is stable after such sample still has the level we read
+  // (it did not change), unless the debounce depth is 1; then we see the change next time.
+  unsigned char level, stable, changes, i;
+  level = fb_level;
+  stable = fb_stable;
+  fb_next = (fb_next & ~stable) | (level & stable);
+  changes = stable & (fb_next ^ fb_previous);
+  for (i = 0; i < 4; i++) {
+    if (changes & (0x03 << (2 * i))) {retries[i] = RS_tranmissions;} }
+  fb_to_send |= changes;
+}
+
+
+unsigned char feedback_pair(unsigned char device)
+{
+  // Returns the two feedback signals of a switch (bit 0: signal 2*device / bit 1: signal 2*device+1)
+  // If one of them is not stable, NOT_STABLE is returned. Just like read_feedbacks(), fb_level
+  // is read before fb_stable.
+  unsigned char level = fb_level >> (2 * device);
+  unsigned char stable = fb_stable >> (2 * device);
+  if ((stable & 0x03) != 0x03) return(NOT_STABLE);
+  return(level & 0x03);
+}
+
+
+unsigned char stable(unsigned char start, unsigned char end)
+{
+  // This function tests if all feedback signals between "start" and "end" are stable
+  unsigned char mask = fb_mask(start, end);
+  return((fb_stable & mask) == mask);
+}
+
+
+unsigned char changed(unsigned char start, unsigned char end)
+{
+  // The function "read_feedbacks" set "changed" (fb_to_send) for each individual feedback signal
+  // Clearing "changed" is done by the functions responsible for transmission via the RS-bus
+  // This function tests if one or more feedback signals between "start" and "end" have changed
+  return((fb_to_send & fb_mask(start, end)) != 0);
+}
+
+
+void save_changes(unsigned char start, unsigned char end)
+{
+  // This function saves the changes for the feedbacks between "start" and "end"
+  // after the nibble to which they belong has been send to the master.
+  // "start" and "end" always cover complete pairs of signals (a nibble holds one or two pairs)
+  unsigned char mask = fb_mask(start, end);
+  unsigned char pair;
+  fb_previous = (fb_previous & ~mask) | (fb_next & mask);
+  for (pair = start / 2; pair <= end / 2; pair++) {
+    if (retries[pair] > 0) {retries[pair] --;}
+    if (retries[pair] == 0) {fb_to_send &= ~(0x03 << (2 * pair));} }
+}
+
+
+//************************************************************************************************
+// The next routine is used to connect to the master
+//************************************************************************************************
+void RS_connect(void)
+{
+  // Register feedback module: send low and high order nibble in 2 consequtive cycles
+  // In case we use two addresses, we should repeat this for the second address
+  // Note that interference on the AVR's input lines during AVR restart requires us 
+  // to wait till all feedback signals have become stable. Note that spurious resets on the
+  // AVR 644A have also been detected (the AVR signals "brown-out" reset, although no power
+  // problems can be measured), which means that the AVR can also be restarted during normal
+  // operation. Therefore we have to make sure we always send correct (thus stable) values.
+  // Registration is a state machine that takes one step per call: a step queues one nibble, 
+  // but only once the previous nibble has been send (thus at most one step per polling cycle).
+  // In this way the main loop never waits, not even if all decoders reconnect at the same time
+  // after a reset of the command station. Each nibble holds the positions at the moment it is
+  // queued, which are saved via save_changes(). Once the last nibble is queued, the module is
+  // connected (RS_Layer_2_connected). If the RS-bus fails halfway, registration starts again.
+  unsigned char nibble;
+  if (RS_Layer_1_active == 0) {connect_step = 0; return;}	// wait till RS-bus is active
+  if (!RS_queue_empty()) return;				// previous nibble not yet send
+  if (skip_uneven_addresses)
+  { // We use two feedback addresses or, in case of switches, 8 (instead of 4) switch addresses
+    switch (connect_step) {
+      case 0: // send first nibble, first address
+        if (!stable(0,7)) return;	// all feedback signals must be stable before we start
+        nibble = (next_position(0)<<DATA_1)
+               | (next_position(1)<<DATA_0)
+               | (0<<DATA_3)
+               | (0<<DATA_2)
+               | (0<<NIBBLE);
+        save_changes(0,1);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);      
+      break;
+      case 1: // send second nibble, first address
+        if (!stable(2,3)) return;
+        nibble = (next_position(2)<<DATA_1)
+               | (next_position(3)<<DATA_0)
+               | (0<<DATA_3)
+               | (0<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(2,3);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+      break;
+      case 2: // send first nibble, second address
+        if (!stable(4,5)) return;
+        nibble = (next_position(4)<<DATA_1)
+               | (next_position(5)<<DATA_0)
+               | (0<<DATA_3)
+               | (0<<DATA_2)
+               | (0<<NIBBLE);
+        save_changes(4,5);
+        format_and_send_RS_data_nibble(My_RS_Addr + 1, nibble);      
+      break;
+      default: // send second nibble, second address
+        if (!stable(6,7)) return;
+        nibble = (next_position(6)<<DATA_1)
+               | (next_position(7)<<DATA_0)
+               | (0<<DATA_3)
+               | (0<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(6,7);
+        format_and_send_RS_data_nibble(My_RS_Addr + 1, nibble);
+        connect_step = 0;
+        RS_Layer_2_connected = 1;	// This module should now be connected to the master station
+        return;
+    }
+  }
+  else
+  { // we use a single feedback address for all 8 feedback signals (thus four switches)
+    switch (connect_step) {
+      case 0: // send first nibble
+        if (!stable(0,7)) return;	// all feedback signals must be stable before we start
+        nibble = (next_position(0)<<DATA_1)
+               | (next_position(1)<<DATA_0)
+               | (next_position(2)<<DATA_3)
+               | (next_position(3)<<DATA_2)
+               | (0<<NIBBLE);
+        save_changes(0,3);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);      
+      break;
+      default: // send second nibble
+        if (!stable(4,7)) return;
+        nibble = (next_position(4)<<DATA_1)
+               | (next_position(5)<<DATA_0)
+               | (next_position(6)<<DATA_3)
+               | (next_position(7)<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(4,7);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+        connect_step = 0;
+        RS_Layer_2_connected = 1;	// This module should now be connected to the master station
+        return;
+    }
+  }
+  connect_step ++;			// next call: next nibble
+}
+
+
+//************************************************************************************************
+// Next routines are used to send the values from the eigth feedback pins
+//************************************************************************************************
+void send_feedbacks(void)
+{ // We send a feedback nibble to the master station if:
+  // 1: the USART has completed transmission of the previous data
+  // 2A: all feedback signals belonging to that nibble are stable, and
+  // 2B: at least one of the feedback signals of that nibble has changed
+  // Depending on whether we "skip_uneven_addresses", the nibble contains the feedback signals
+  // of one switch (we skip uneven addresses), or two switches (we do not skip addresses).
+  // With "slow switches", such as those driven by a motor, the first feedback signal may be
+  // changed a few seconds before the second is changed. As a consequence, for a limited period,
+  // both feedback signals of a switch (switch is red / green) may be high (or low).
+  // After a short time, however, only one of them will remain high (or low).
+  unsigned char nibble;
+  // check if we may send data (thus the USART has completed transmission of the previous data)
+  // Although the transmit queue could hold more, we only queue a nibble if the previous one 
+  // has been send: the nibble must contain the feedback positions at the moment of sending.
+  if (RS_queue_empty()) { 
+    // Check if we use 2 feedback addresses or, for switches, 8 (instead of 4) switch addresses
+    if (skip_uneven_addresses) { 
+      if (stable(0,1) && changed(0,1)) {
+        nibble = (next_position(0)<<DATA_1)
+               | (next_position(1)<<DATA_0)
+               | (next_position(0)<<DATA_3)
+               | (next_position(1)<<DATA_2)
+               | (0<<NIBBLE);
+        save_changes(0,1);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+      } // if (stable(0,1)  ...
+      else if (stable(2,3) && changed(2,3)) {
+        nibble = (next_position(2)<<DATA_1)
+               | (next_position(3)<<DATA_0)
+               | (next_position(2)<<DATA_3)
+               | (next_position(3)<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(2,3);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+      } // if (stable(2,3)  ...
+      else if (stable(4,5) && changed(4,5)) {
+        nibble = (next_position(4)<<DATA_1)
+               | (next_position(5)<<DATA_0)
+               | (next_position(4)<<DATA_3)
+               | (next_position(5)<<DATA_2)
+               | (0<<NIBBLE);             
+        save_changes(4,5);
+        format_and_send_RS_data_nibble(My_RS_Addr + 1, nibble);
+      } // if (stable(4,5)  ...
+      else if (stable(6,7) && changed(6,7)) {
+        nibble = (next_position(6)<<DATA_1)
+               | (next_position(7)<<DATA_0)
+               | (next_position(6)<<DATA_3)
+               | (next_position(7)<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(6,7);
+        format_and_send_RS_data_nibble(My_RS_Addr + 1, nibble);
+      } // if (stable(6,7)  ...
+    } // if (skip_uneven_addresses)
+    else
+    { // we use a single feedback address for all 8 feedback signals (thus four switches)
+      if (stable(0,3) && changed(0,3)) {
+        nibble = (next_position(0)<<DATA_1)
+               | (next_position(1)<<DATA_0)
+               | (next_position(2)<<DATA_3)
+               | (next_position(3)<<DATA_2)
+               | (0<<NIBBLE);
+        save_changes(0,3);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+      } // if (stable(0,3)  ...
+      else if (stable(4,7) && changed(4,7)) {
+        nibble = (next_position(4)<<DATA_1)
+               | (next_position(5)<<DATA_0)
+               | (next_position(6)<<DATA_3)
+               | (next_position(7)<<DATA_2)
+               | (1<<NIBBLE);             
+        save_changes(4,7);
+        format_and_send_RS_data_nibble(My_RS_Addr, nibble);
+      } // else if stable(4,7)  ...
+    }   // else  
+  }     // if (RS_queue_empty())
+}
+
+
+//************************************************************************************************
+// This routine is called from main every 20 milliseconds (to avoid processor overload / debounce)
+//************************************************************************************************
+void send_switch_feedback(void)
+{ // Check if My_RS_Addr is initialised
+  if (My_RS_Addr > 0) {
+    read_feedbacks();   
+    if (RS_Layer_2_connected == 0) {RS_connect();}	// Try to connect
+      else {send_feedbacks();}
+  }
+}
+
+
@@ -1,19 +1,32 @@
-//*****************************************************************************************************
-//
-// file:      switch_feedback.h
-//
-// purpose:   Header file for the determining switch positions for sending feedback
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-//
-// history:   2010-11-10 V0.1 Initial version
-//            2011-02-06 V0.2 First complete production version
-//
-//*****************************************************************************************************
-#pragma once
-
-void init_switch_feedback(void);
-void send_switch_feedback(void);
-
+//*****************************************************************************************************
+//
+// file:      switch_feedback.h
+//
+// purpose:   Header file for the determining switch positions for sending feedback
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+//
+// history:   2010-11-10 V0.1 Initial version
+//            2011-02-06 V0.2 First complete production version
+//            2026-10-16 V0.3 sample_feedbacks added, for sampling from the Timer2 ISR
+//                            feedback_pair added, for the throw time measurement in switch.c
+//                            feedback_sampled removed (EV_FEEDBACK, see config.h)
+//                            init_feedback_sampling added, to reload CV35 after a CV write
+//                            sample_feedbacks returns if there is work for send_switch_feedback
+//
+//*****************************************************************************************************
+#pragma once
+
+extern unsigned char feedback_fast;		// 1: sample_feedbacks() is called each 1ms by the Timer2 ISR
+
+void init_switch_feedback(void);
+void init_feedback_sampling(void);		// called from cv_pom, after a CV write (CV35)
+unsigned char sample_feedbacks(void);		// returns 1 if send_switch_feedback() has work to do
+
+// The (stable) feedback signals of a switch, or NOT_STABLE. Used to measure the throw time
+#define NOT_STABLE 0xFF
+unsigned char feedback_pair(unsigned char device);
+void send_switch_feedback(void);
+
@@ -1,33 +1,54 @@
-//------------------------------------------------------------------------
-//
-// OpenDCC - OpenDecoder
-//
-// Copyright (c) 2007 Kufer
-//
-// This source file is subject of the GNU general public license 2,
-// that is available at the world-wide-web at
-// http://www.gnu.org/licenses/gpl.txt
-// 
-//------------------------------------------------------------------------
-//
-// file:      timer1.h
-// author:    Wolfgang Kufer
-// contact:   kufer@gmx.de
-// webpage:   http://www.opendcc.de
-// history:   2007-02-14 V0.1 kw copied from opendecoder.c
-//
-//------------------------------------------------------------------------
-//
-// purpose:   flexible general purpose decoder for dcc
-//            here: timer1 defintions
-//
-//
-//------------------------------------------------------------------------
-#pragma once
-
-// Called by main
-void init_timer1(void);
-
-// called by RS_Send()
-unsigned char time_for_next_feedback(void);
-unsigned char start_up_phase(void);
+//------------------------------------------------------------------------
+//
+// OpenDCC - OpenDecoder
+//
+// Copyright (c) 2007 Kufer
+//
+// This source file is subject of the GNU general public license 2,
+// that is available at the world-wide-web at
+// http://www.gnu.org/licenses/gpl.txt
+// 
+//------------------------------------------------------------------------
+//
+// file:      timer1.h
+// author:    Wolfgang Kufer
+// contact:   kufer@gmx.de
+// webpage:   http://www.opendcc.de
+// history:   2007-02-14 V0.1 kw copied from opendecoder.c
+//            2026-10-16 V0.2    Software timers (delta list) replace the per-tick counters
+//
+//------------------------------------------------------------------------
+//
+// purpose:   flexible general purpose decoder for dcc
+//            here: timer1 defintions
+//
+//
+//------------------------------------------------------------------------
+#pragma once
+
+// Timer 1 runs with a fixed prescaler and counts from 0 to T1_TOP (=ICR1); one such cycle
+// takes TICK_PERIOD. TCNT1 may therefore also be read as a free running clock, which wraps
+// after T1_TOP. This is used by the timestamp variant of the DCC receiver.
+#define T1_PRESCALER   8    // may be 1, 8, 64, 256, 1024
+#define T1_TOP         (F_CPU / 1000000L * TICK_PERIOD / T1_PRESCALER)
+
+// Called by main
+void init_timer1(void);
+
+// Software timers. A module owns a t_timer (normally a global variable) and starts it with the
+// number of ticks (TICK_PERIOD, 1..255) after which callback should be called. If period is not 0,
+// the timer is restarted with period ticks each time it expires; otherwise it is a one-shot timer.
+// Starting a timer that is already running restarts it. The callbacks are called from main (by
+// run_timers), thus not from the ISR; they may start and stop timers, including their own.
+// start_timer and stop_timer disable interrupts while they change the list, and then restore SREG.
+typedef struct t_timer {
+  struct t_timer *next;         // next timer in the delta list
+  unsigned char delta;          // ticks after the expiry of the previous timer in the list
+  unsigned char period;         // 0: one-shot / 1..255: periodic, with this number of ticks
+  void (*callback)(void);       // called when the timer expires
+} t_timer;
+
+void start_timer(t_timer *timer, void (*callback)(void), unsigned char ticks, unsigned char period);
+void stop_timer(t_timer *timer);
+unsigned char timer_running(t_timer *timer);	// 1: the timer is started, and not yet expired
+void run_timers(void);          // called from main, for EV_TIMER